@@ -0,0 +1,55 @@
+#include "powerdiagram/FromBinary.hpp"
+#include "powerdiagram/FromCSV.hpp"
+
+#include <Eigen/Dense>
+#include <gflags/gflags.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+DECLARE_bool(help);
+DECLARE_string(helpmatch);
+
+int main(int argc, char *argv[])
+{
+    std::string usage;
+    usage += "This program converts spheres from a pair of CSV files to the binary sphere format.\n";
+    usage += "Sample usage:\n\t";
+    usage += argv[0];
+    usage += " <centers> <radii> <output>.spheres\n";
+    gflags::SetUsageMessage(usage);
+    gflags::ParseCommandLineNonHelpFlags(&argc, &argv, true);
+    if (FLAGS_help) {
+        FLAGS_help = false;
+        FLAGS_helpmatch = "csv2spheres";
+    }
+    gflags::HandleCommandLineHelpFlags();
+
+    if (argc < 4) {
+        std::cout << gflags::ProgramUsage();
+        return 2;
+    }
+
+    if (!FromBinary::isBinary(argv[3])) {
+        std::cerr << "Error: The output file has to end in .spheres" << std::endl;
+        return 1;
+    }
+
+    try {
+        Eigen::MatrixXd centers;
+        Eigen::VectorXd radii;
+        FromCSV::read(argv[1], argv[2], centers, radii);
+
+        if (radii.size() < 1) {
+            std::cerr << "Error: Empty input. Maybe the Filenames are wrong?"<< std::endl;
+            return 1;
+        }
+
+        FromBinary::write(argv[3], centers, radii);
+    } catch (const std::runtime_error& error) {
+        std::cerr << "Error: " << error.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
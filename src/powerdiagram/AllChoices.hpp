@@ -3,7 +3,11 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 class AllChoices {
@@ -65,6 +69,178 @@ class AllChoices {
                     prepend);
         }
 
+        /**
+         * @brief Start an in-place enumeration of the combinations of length
+         * indices from [0, count), see nextIndexGroup.
+         *
+         * @param group Set to the lexicographically first combination.
+         *
+         * @return False if there is no combination at all.
+         */
+        template<typename index_t>
+        static bool firstIndexGroup(size_t length, size_t count, std::vector<index_t>& group)
+        {
+            group.resize(length);
+            std::iota(group.begin(), group.end(), 0);
+
+            return length <= count;
+        }
+
+        /**
+         * @brief Advance a combination of indices from [0, count) to the next
+         * one in lexicographic order without allocating, i.e. in the order
+         * of indexGroupsOfLength.
+         *
+         * @return False if group was the last combination.
+         */
+        template<typename index_t>
+        static bool nextIndexGroup(size_t count, std::vector<index_t>& group)
+        {
+            const size_t length = group.size();
+
+            // Find the last index which can still be increased.
+            size_t i = length;
+            while (i > 0 && static_cast<size_t>(group[i - 1]) == count - length + i - 1) {
+                --i;
+            }
+            if (i == 0) {
+                return false;
+            }
+
+            ++group[i - 1];
+            for (size_t j = i; j < length; ++j) {
+                group[j] = group[j - 1] + 1;
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief The number of combinations of length indices from
+         * [0, count), i.e. the binomial coefficient.
+         *
+         * @throws std::runtime_error If it does not fit into a size_t. Ranks
+         * of combinations are bounded by it, so they fit as well.
+         */
+        static size_t countIndexGroups(size_t length, size_t count)
+        {
+            if (length > count) {
+                return 0;
+            }
+
+            length = std::min(length, count - length);
+            size_t result = 1;
+            for (size_t i = 1; i <= length; ++i) {
+                // Every step is again a binomial coefficient, so i divides
+                // result * factor. Cancelling their common divisor first
+                // keeps this exact, and only the product can overflow.
+                size_t divisor = i;
+                size_t factor = count - length + i;
+                size_t common = result;
+                for (size_t rest = divisor; rest != 0;) {
+                    common %= rest;
+                    std::swap(common, rest);
+                }
+                divisor /= common;
+                factor /= divisor;
+                result /= common;
+
+                if (result > std::numeric_limits<size_t>::max() / factor) {
+                    throw std::runtime_error(
+                            "There are too many groups of " + std::to_string(length) +
+                            " out of " + std::to_string(count) + " to count");
+                }
+                result *= factor;
+            }
+
+            return result;
+        }
+
+        /**
+         * @brief The position of a combination of indices from [0, count) in
+         * the lexicographic order of nextIndexGroup.
+         *
+         * In the combinatorial number system, a combination c_1 > ... > c_k
+         * is numbered by the sum of the binomial coefficients (c_i over i),
+         * which orders the combinations colexicographically. Mirroring the
+         * indices at count - 1 turns this into the lexicographic order
+         * backwards.
+         */
+        template<typename index_t>
+        static size_t rankIndexGroup(size_t count, const std::vector<index_t>& group)
+        {
+            const size_t length = group.size();
+
+            size_t mirrored = 0;
+            for (size_t i = 0; i < length; ++i) {
+                mirrored += countIndexGroups(length - i, count - 1 - group[i]);
+            }
+
+            return countIndexGroups(length, count) - 1 - mirrored;
+        }
+
+        /**
+         * @brief The inverse of rankIndexGroup, which allows starting an
+         * enumeration with nextIndexGroup anywhere.
+         *
+         * @param group Set to the combination with the given rank.
+         *
+         * @return False if there are no more than rank combinations.
+         */
+        template<typename index_t>
+        static bool unrankIndexGroup(
+                size_t rank,
+                size_t length,
+                size_t count,
+                std::vector<index_t>& group)
+        {
+            const size_t total = countIndexGroups(length, count);
+            group.resize(length);
+            if (rank >= total) {
+                return false;
+            }
+
+            // Greedily take the largest mirrored index whose binomial
+            // coefficient still fits.
+            size_t mirrored = total - 1 - rank;
+            size_t bound = count;
+            for (size_t i = 0; i < length; ++i) {
+                size_t index = bound - 1;
+                while (countIndexGroups(length - i, index) > mirrored) {
+                    --index;
+                }
+
+                mirrored -= countIndexGroups(length - i, index);
+                group[i] = count - 1 - index;
+                bound = index;
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Call function(group) for the combinations of length indices
+         * from [0, count) with ranks in [begin, end), in lexicographic order.
+         * The same group is advanced in place for every call, so disjoint
+         * ranges can be enumerated independently, e.g. to split the work or
+         * to resume it.
+         */
+        template<typename index_t, typename Function>
+        static void forEachIndexGroup(
+                size_t length,
+                size_t count,
+                size_t begin,
+                size_t end,
+                Function&& function)
+        {
+            std::vector<index_t> group;
+            for (bool more = begin < end && unrankIndexGroup(begin, length, count, group);
+                    more;
+                    more = ++begin < end && nextIndexGroup(count, group)) {
+                function(static_cast<const std::vector<index_t>&>(group));
+            }
+        }
+
     private:
         AllChoices();
 
@@ -1,11 +1,14 @@
 #ifndef BIDIRECTIONALGRAPH_H
 #define BIDIRECTIONALGRAPH_H
 
+#include "KeySet.hpp"
+
+#include <cstddef>
 #include <deque>
-#include <set>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 /**
  * @brief A datastructure containing a directed graph with efficient lookup in both directions.
@@ -15,7 +18,7 @@
  * A BidirectionalGraph uses Keys as an index of the nodes and stores a Value
  * in every node.
  * A node is called minimal if it has no predecessors and maximal if it has no
- * successors.
+ * successors. Both sets are kept up to date on every change.
  *
  * @tparam Key_t Type of Objects used to index nodes.
  * @tparam Value_t Type of Values stored in each node.
@@ -23,22 +26,41 @@
 template <typename Key_t, typename Value_t>
 class BidirectionalGraph {
     public:
-        // We use std::set here since we want to calculate intersections.
-        using Keys_t = std::set<Key_t>;
+        // Sorted, so we can calculate intersections, but without a tree
+        // node per edge.
+        using Keys_t = KeySet<Key_t>;
         using Entry_t = std::tuple<Value_t, Keys_t, Keys_t>;
         using Graph_t = std::unordered_map<Key_t, Entry_t>;
 
-        BidirectionalGraph(): rep_() { }
+        BidirectionalGraph():
+            rep_(),
+            minimals_(),
+            maximals_()
+        { }
         virtual ~BidirectionalGraph() { }
 
+        size_t size() const
+        {
+            return rep_.size();
+        }
+        /**
+         * @brief Call function with the key of every node, in no particular order.
+         */
+        template <typename Function>
+        void forEachNode(Function&& function) const
+        {
+            for (auto& item : rep_) {
+                function(item.first);
+            }
+        }
+
         bool nodeExists(const Key_t& key) const
         {
             return rep_.count(key) != 0;
         }
         bool edgeExists(const Key_t& from, const Key_t& to) const
         {
-            return nodeExists(from) && nodeExists(to) &&
-                immSuccs(from).find(to) != immSuccs(from).end();
+            return nodeExists(from) && nodeExists(to) && immSuccs(from).contains(to);
         }
 
         Value_t& value(const Key_t& key)
@@ -100,29 +122,13 @@ class BidirectionalGraph {
         {
             return successors(key).size() == 0;
         }
-        Keys_t minimalElements() const
+        const Keys_t& minimalElements() const
         {
-            Keys_t res;
-
-            for (auto& item : rep_) {
-                if (isMinimal(item.first)) {
-                    res.insert(item.first);
-                }
-            }
-
-            return res;
+            return minimals_;
         }
-        Keys_t maximalElements() const
+        const Keys_t& maximalElements() const
         {
-            Keys_t res;
-
-            for (auto& item : rep_) {
-                if (isMaximal(item.first)) {
-                    res.insert(item.first);
-                }
-            }
-
-            return res;
+            return maximals_;
         }
 
         /**
@@ -150,6 +156,8 @@ class BidirectionalGraph {
         void insertNode(const Key_t& key, const Value_t& value)
         {
             rep_[key] = std::make_tuple(value, Keys_t(), Keys_t());
+            minimals_.insert(key);
+            maximals_.insert(key);
         }
 
         void insertEdge(const Key_t& from, const Key_t& to)
@@ -157,18 +165,29 @@ class BidirectionalGraph {
             if (nodeExists(from) && nodeExists(to)) {
                 immSuccs(from).insert(to);
                 immPreds(to).insert(from);
+                maximals_.erase(from);
+                minimals_.erase(to);
             }
         }
 
         void deleteNode(const Key_t& key)
         {
-            for (auto& succ : immSuccs(key)) {
+            for (auto succ : immSuccs(key)) {
                 immPreds(succ).erase(key);
+                if (isMinimal(succ)) {
+                    minimals_.insert(succ);
+                }
             }
-            for (auto& pred : immPreds(key)) {
+            for (auto pred : immPreds(key)) {
                 immSuccs(pred).erase(key);
+                if (isMaximal(pred)) {
+                    maximals_.insert(pred);
+                }
             }
 
+            // The key might be a reference into the erased node.
+            minimals_.erase(key);
+            maximals_.erase(key);
             rep_.erase(key);
         }
         void deleteEdge(const Key_t& from, const Key_t& to)
@@ -176,6 +195,12 @@ class BidirectionalGraph {
             if (edgeExists(from, to)) {
                 immSuccs(from).erase(to);
                 immPreds(to).erase(from);
+                if (isMaximal(from)) {
+                    maximals_.insert(from);
+                }
+                if (isMinimal(to)) {
+                    minimals_.insert(to);
+                }
             }
         }
 
@@ -206,25 +231,27 @@ class BidirectionalGraph {
             //NOTE(mrksr): These statics improve the speed somewhat, but are a
             //problem for thread safety. Since the structure is not thread-safe
             //anyway, this is not so much of a problem.
-            static std::unordered_set<Key_t> visited;
-            static std::deque<Key_t> tovisit;
+            // They are per thread, so concurrent searches on a graph which is
+            // not modified meanwhile are fine.
+            static thread_local std::unordered_set<Key_t> visited;
+            static thread_local std::deque<Key_t> tovisit;
             tovisit.clear();
             visited.clear();
 
             tovisit.push_back(from);
             visited.insert(from);
 
-            Keys_t result;
+            std::vector<Key_t> result;
             while (!tovisit.empty()) {
                 auto element = tovisit.front();
                 tovisit.pop_front();
 
                 if (filter(element)) {
-                    result.insert(element);
+                    result.push_back(element);
                 }
 
                 if (cont(element)) {
-                    for (auto& item : next(element)) {
+                    for (auto item : next(element)) {
                         if (visited.find(item) == visited.end()) {
                             tovisit.push_back(item);
                             visited.insert(item);
@@ -233,7 +260,7 @@ class BidirectionalGraph {
                 }
             }
 
-            return result;
+            return Keys_t(result.begin(), result.end());
         }
 
         //FIXME(mrksr): It would be great to combine findNotes and
@@ -254,8 +281,10 @@ class BidirectionalGraph {
             //NOTE(mrksr): These statics improve the speed somewhat, but are a
             //problem for thread safety. Since the structure is not thread-safe
             //anyway, this is not so much of a problem.
-            static std::unordered_set<Key_t> visited;
-            static std::deque<Key_t> tovisit;
+            // They are per thread, so concurrent searches on a graph which is
+            // not modified meanwhile are fine.
+            static thread_local std::unordered_set<Key_t> visited;
+            static thread_local std::deque<Key_t> tovisit;
             tovisit.clear();
             visited.clear();
 
@@ -264,13 +293,13 @@ class BidirectionalGraph {
                 visited.insert(from);
             }
 
-            Keys_t result;
+            std::vector<Key_t> result;
             while (!tovisit.empty()) {
                 auto element = tovisit.front();
                 tovisit.pop_front();
 
                 bool anyNextValid = false;
-                for (auto& item : next(element)) {
+                for (auto item : next(element)) {
                     if (visited.find(item) != visited.end()) {
                         anyNextValid = true;
                     } else if (predicate(item)) {
@@ -284,15 +313,17 @@ class BidirectionalGraph {
                 }
 
                 if (!anyNextValid) {
-                    result.insert(element);
+                    result.push_back(element);
                 }
             }
 
-            return result;
+            return Keys_t(result.begin(), result.end());
         }
 
     private:
         Graph_t rep_;
+        Keys_t minimals_;
+        Keys_t maximals_;
 
         const Keys_t& immPreds(const Key_t& key) const
         {
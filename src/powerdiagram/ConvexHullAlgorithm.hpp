@@ -4,10 +4,26 @@
 #include "IncidenceLattice.hpp"
 
 #include <Eigen/Dense>
+#include <algorithm>
+#include <unordered_map>
 #include <vector>
 
 class ConvexHullAlgorithm {
     public:
+        using Lattice_t = IncidenceLattice<Eigen::VectorXd>;
+        // Maps the keys of the vertices to the indices of their points.
+        using Indices_t = std::unordered_map<Lattice_t::Key_t, size_t>;
+
+        /**
+         * @brief Which facets of the hull to compute.
+         */
+        enum class Part {
+            Full,
+            // Only the facets whose outward normal has a negative last
+            // coordinate, together with their faces.
+            Lower
+        };
+
         ConvexHullAlgorithm() { }
         virtual ~ConvexHullAlgorithm() { }
 
@@ -16,10 +32,57 @@ class ConvexHullAlgorithm {
          * Calculates the d-dimensional convex hull of the points provided. The
          * incidence lattice returned should at least contain (d-2)-faces
          * besides 0-faces (vertices) and (d-1)-faces (facets).
+         * The values of the facets are their outward unit normals if the
+         * algorithm computes them anyway, and empty otherwise.
+         *
+         * @param points One point per column. Since Eigen stores the columns
+         * contiguously, the matrix can be handed to most libraries as is.
+         * @param indices Set to the column of every vertex. Points which
+         * coincide are only one vertex.
+         * @param part Facets which are not part of this are never added to
+         * the lattice.
          *
          * @return An incidence lattice of the convex hull.
          */
-        virtual IncidenceLattice<Eigen::VectorXd> hullOf(const std::vector<Eigen::VectorXd>& points) = 0;
+        virtual IncidenceLattice<Eigen::VectorXd> hullOf(
+                const Eigen::MatrixXd& points,
+                Indices_t& indices,
+                Part part) = 0;
+
+        /**
+         * @brief How far points may be from the hyperplane of a facet and
+         * still be treated as lying in it, e.g. when nearly coplanar facets
+         * are merged.
+         * The default is a bound for backends with floating point predicates
+         * like Qhull, relative to the largest coordinate.
+         *
+         * @param points The points the hull would be computed of.
+         */
+        virtual double tolerance(const Eigen::MatrixXd& points) const
+        {
+            return 1e-12 * std::max(1.0, points.cwiseAbs().maxCoeff());
+        }
+
+        IncidenceLattice<Eigen::VectorXd> hullOf(
+                const Eigen::MatrixXd& points,
+                Indices_t& indices)
+        {
+            return hullOf(points, indices, Part::Full);
+        }
+        IncidenceLattice<Eigen::VectorXd> hullOf(const Eigen::MatrixXd& points)
+        {
+            Indices_t indices;
+            return hullOf(points, indices, Part::Full);
+        }
+        IncidenceLattice<Eigen::VectorXd> hullOf(const std::vector<Eigen::VectorXd>& points)
+        {
+            Eigen::MatrixXd matrix(points[0].size(), points.size());
+            for (size_t i = 0; i < points.size(); ++i) {
+                matrix.col(i) = points[i];
+            }
+
+            return hullOf(matrix);
+        }
 
     private:
 };
@@ -0,0 +1,594 @@
+#include "ConvexHullParallel.hpp"
+
+#include "Parallel.hpp"
+#include "PowerLocator.hpp"
+#include "SimplicialHull.hpp"
+
+#include <gflags/gflags.h>
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+DECLARE_bool(verbose);
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using Lattice_t = IncidenceLattice<VectorXd>;
+
+/**
+ * @brief A facet of a partial hull, given by columns of the full input.
+ */
+struct PieceFacet {
+    std::vector<size_t> vertices;
+    // The outward normal, if the backend provided one.
+    VectorXd normal;
+    std::vector<std::vector<size_t>> ridges;
+    // Whether a ridge has no other facet in the partial hull.
+    std::vector<bool> open;
+};
+
+/**
+ * @brief The lower hull of some columns of points as a list of facets.
+ */
+static std::vector<PieceFacet> piecesOf(
+        ConvexHullAlgorithm& hull,
+        const MatrixXd& points,
+        const std::vector<size_t>& columns)
+{
+    MatrixXd part(points.rows(), columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        part.col(i) = points.col(columns[i]);
+    }
+
+    ConvexHullAlgorithm::Indices_t indices;
+    const auto lattice = hull.hullOf(part, indices, ConvexHullAlgorithm::Part::Lower);
+
+    const auto columnsOf = [&](const Lattice_t::Keys_t& keys) {
+        std::vector<size_t> result;
+        for (auto key : keys) {
+            result.push_back(columns[indices.at(key)]);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+
+    std::vector<PieceFacet> facets;
+    for (auto facet : lattice.maximals()) {
+        PieceFacet piece;
+        piece.vertices = columnsOf(lattice.minimalsOf(facet));
+        piece.normal = lattice.value(facet);
+        for (auto ridge : lattice.predecessors(facet)) {
+            piece.ridges.push_back(columnsOf(lattice.minimalsOf(ridge)));
+            piece.open.push_back(lattice.successors(ridge).size() == 1);
+        }
+        facets.push_back(std::move(piece));
+    }
+
+    return facets;
+}
+
+/**
+ * @brief The outward normal of the lower facet through some points, or an
+ * empty vector if they do not span a hyperplane.
+ */
+static VectorXd lowerNormalOf(const std::vector<size_t>& vertices, const MatrixXd& points)
+{
+    const size_t dimension = points.rows();
+
+    MatrixXd A(vertices.size() - 1, dimension);
+    for (size_t i = 1; i < vertices.size(); ++i) {
+        A.row(i - 1) = (points.col(vertices[i]) - points.col(vertices[0])).transpose();
+    }
+
+    const Eigen::FullPivLU<MatrixXd> lu(A);
+    if (lu.rank() != static_cast<Eigen::Index>(dimension - 1)) {
+        return VectorXd();
+    }
+    VectorXd normal = lu.kernel().col(0).normalized();
+    if (normal[dimension - 1] > 0) {
+        normal *= -1;
+    }
+
+    return normal;
+}
+
+/**
+ * @brief A horizontal normal of a ridge, i.e. of its projection to the first
+ * coordinates, or an empty vector if the projection is degenerate.
+ */
+static VectorXd sideNormalOf(const std::vector<size_t>& ridge, const MatrixXd& points)
+{
+    const size_t dimension = points.rows() - 1;
+
+    VectorXd normal = VectorXd::Zero(dimension + 1);
+    if (dimension == 1) {
+        normal[0] = 1;
+    } else {
+        MatrixXd A(ridge.size() - 1, dimension);
+        for (size_t i = 1; i < ridge.size(); ++i) {
+            A.row(i - 1) = (points.col(ridge[i]) - points.col(ridge[0])).head(dimension).transpose();
+        }
+
+        const Eigen::FullPivLU<MatrixXd> lu(A);
+        if (lu.rank() != static_cast<Eigen::Index>(dimension - 1)) {
+            return VectorXd();
+        }
+        normal.head(dimension) = lu.kernel().col(0).normalized();
+    }
+
+    return normal;
+}
+
+/**
+ * @brief Where the points lie relative to a hyperplane, apart from some of
+ * them which lie on it.
+ */
+enum class Side {
+    // All points are further above it than the tolerance.
+    Above,
+    // Some point is further below it than the tolerance.
+    Below,
+    // Neither, some points are within the tolerance of it.
+    Within
+};
+
+/**
+ * @brief Where the points lie relative to the hyperplane of normal and offset,
+ * i.e. whether normal.dot(point) exceeds offset.
+ *
+ * @param beyond If not null, set to the point furthest below the hyperplane
+ * if the result is Side::Below.
+ */
+static Side sideOf(
+        const VectorXd& normal,
+        double offset,
+        const std::vector<size_t>& on,
+        const PowerLocator& locator,
+        double tolerance,
+        size_t* beyond = nullptr)
+{
+    if (locator.existsBeyond(normal, offset + tolerance, on, beyond)) {
+        return Side::Below;
+    }
+    if (locator.existsBeyond(normal, offset - tolerance, on)) {
+        return Side::Within;
+    }
+
+    return Side::Above;
+}
+
+/**
+ * @brief Where the points lie relative to a facet of a partial hull. It is a
+ * facet of the lower hull of all points if they are all above it.
+ *
+ * The points are tested against the hyperplane itself rather than by their
+ * powers at the facet's power point. Facets near the boundary of the
+ * projection are nearly vertical, so their power points are far away and
+ * powers there cannot resolve the tolerance.
+ *
+ * @param beyond If not null, set to the point furthest below the hyperplane
+ * if there is one.
+ */
+static Side sideOfFacet(
+        const PieceFacet& facet,
+        const MatrixXd& points,
+        const PowerLocator& locator,
+        double tolerance,
+        size_t* beyond = nullptr)
+{
+    const size_t dimension = points.rows();
+
+    VectorXd normal = facet.normal;
+    if (static_cast<size_t>(normal.size()) != dimension) {
+        normal = lowerNormalOf(facet.vertices, points);
+    }
+    if (normal.size() == 0) {
+        return Side::Within;
+    }
+    if (normal[dimension - 1] >= 0) {
+        return Side::Below;
+    }
+
+    const double offset = normal.dot(points.col(facet.vertices[0]));
+    return sideOf(normal, offset, facet.vertices, locator, tolerance, beyond);
+}
+
+/**
+ * @brief Whether a ridge lies on the boundary of the projection of all points
+ * to their first coordinates, so there is only one lower facet at it.
+ * Throws std::runtime_error if other points are within the tolerance of the
+ * vertical hyperplane through it, which the serial hull may or may not add
+ * to a vertical facet there.
+ */
+static bool isBoundary(
+        const std::vector<size_t>& ridge,
+        const MatrixXd& points,
+        const PowerLocator& locator,
+        double tolerance)
+{
+    const VectorXd normal = sideNormalOf(ridge, points);
+    if (normal.size() == 0) {
+        throw std::runtime_error("A ridge has a degenerate projection");
+    }
+
+    const double offset = normal.dot(points.col(ridge[0]));
+    const auto side = sideOf(normal, offset, ridge, locator, tolerance);
+    const auto otherSide = sideOf(-normal, -offset, ridge, locator, tolerance);
+    if (side == Side::Above || otherSide == Side::Above) {
+        return true;
+    }
+    if (side == Side::Within || otherSide == Side::Within) {
+        throw std::runtime_error("Points are nearly collinear at the boundary");
+    }
+
+    return false;
+}
+
+/**
+ * @brief Split a facet of a partial hull into the simplices of the lower hull
+ * of the points near it, i.e. within the tolerance of its hyperplane.
+ *
+ * The backend may have merged them, and only the simplices can be compared
+ * to those of the other pieces. Facets with points clearly below them are
+ * not facets of the whole hull and are returned as they are.
+ * Throws std::runtime_error if points near the facet are coplanar up to
+ * rounding, which has no unique triangulation.
+ */
+static std::vector<PieceFacet> simplicesOf(
+        const PieceFacet& facet,
+        const MatrixXd& points,
+        const PowerLocator& locator,
+        double tolerance,
+        double rounding)
+{
+    const size_t dimension = points.rows();
+
+    PieceFacet whole = facet;
+    if (static_cast<size_t>(whole.normal.size()) != dimension) {
+        whole.normal = lowerNormalOf(whole.vertices, points);
+        if (whole.normal.size() == 0) {
+            throw std::runtime_error("A facet is degenerate");
+        }
+    }
+
+    const double offset = whole.normal.dot(points.col(whole.vertices[0]));
+    if (whole.vertices.size() == dimension ||
+            locator.existsBeyond(whole.normal, offset + tolerance, whole.vertices)) {
+        return { whole };
+    }
+
+    // Few points are that close to a hyperplane, unless the input is
+    // degenerate.
+    std::vector<size_t> near = whole.vertices;
+    size_t index;
+    while (locator.existsBeyond(whole.normal, offset - tolerance, near, &index)) {
+        near.insert(std::lower_bound(near.begin(), near.end(), index), index);
+        if (near.size() > 4 * dimension) {
+            throw std::runtime_error("Too many points are nearly coplanar");
+        }
+    }
+
+    // A simplex is a lower facet if all other points are above it.
+    std::vector<PieceFacet> simplices;
+    std::map<std::vector<size_t>, size_t> ridges;
+    std::vector<bool> chosen(near.size(), false);
+    std::fill(chosen.begin(), chosen.begin() + dimension, true);
+    do {
+        PieceFacet simplex;
+        for (size_t i = 0; i < near.size(); ++i) {
+            if (chosen[i]) {
+                simplex.vertices.push_back(near[i]);
+            }
+        }
+
+        simplex.normal = lowerNormalOf(simplex.vertices, points);
+        if (simplex.normal.size() == 0) {
+            continue;
+        }
+
+        const double simplexOffset = simplex.normal.dot(points.col(simplex.vertices[0]));
+        double furthest = -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < near.size(); ++i) {
+            if (!chosen[i]) {
+                furthest = std::max(furthest, simplex.normal.dot(points.col(near[i])) - simplexOffset);
+            }
+        }
+        if (furthest > rounding) {
+            continue;
+        }
+        if (furthest >= -rounding) {
+            throw std::runtime_error("Points are coplanar with a facet");
+        }
+
+        for (size_t i = 0; i < dimension; ++i) {
+            auto ridge = simplex.vertices;
+            ridge.erase(ridge.begin() + i);
+            ++ridges[ridge];
+            simplex.ridges.push_back(std::move(ridge));
+        }
+        simplices.push_back(std::move(simplex));
+    } while (std::prev_permutation(chosen.begin(), chosen.end()));
+
+    for (auto& simplex : simplices) {
+        for (auto& ridge : simplex.ridges) {
+            simplex.open.push_back(ridges[ridge] == 1);
+        }
+    }
+
+    return simplices;
+}
+
+IncidenceLattice<VectorXd> ConvexHullParallel::hullOf(
+        const MatrixXd& points,
+        Indices_t& indices,
+        Part part)
+{
+    const size_t slabs = std::min(Parallel::threads(), points.cols() / std::max<size_t>(minSlabSize_, 1));
+    if (part == Part::Lower && slabs >= 2) {
+        try {
+            return mergedHullOf(points, indices, slabs);
+        } catch (const std::runtime_error& error) {
+            if (FLAGS_verbose) {
+                std::cerr
+                    << "Parallel hull failed (" << error.what()
+                    << "), computing it serially." << std::endl;
+            }
+        }
+    }
+
+    return serial_->hullOf(points, indices, part);
+}
+
+double ConvexHullParallel::tolerance(const MatrixXd& points) const
+{
+    return serial_->tolerance(points);
+}
+
+IncidenceLattice<VectorXd> ConvexHullParallel::mergedHullOf(
+        const MatrixXd& points,
+        Indices_t& indices,
+        size_t slabs)
+{
+    const size_t count = points.cols();
+    const size_t dimension = points.rows();
+    // The serial hull would merge everything within this.
+    const double tolerance = this->tolerance(points);
+
+    // Split into slabs of equal size along the first coordinate.
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&points](size_t a, size_t b) {
+            return points(0, a) < points(0, b);
+        });
+
+    std::vector<std::vector<size_t>> slabColumns(slabs);
+    for (size_t slab = 0; slab < slabs; ++slab) {
+        slabColumns[slab].assign(
+                order.begin() + slab * count / slabs,
+                order.begin() + (slab + 1) * count / slabs);
+    }
+
+    if (FLAGS_verbose) {
+        std::cerr << "Computing the hulls of " << slabs << " slabs" << std::endl;
+    }
+
+    std::vector<std::vector<PieceFacet>> pieces(slabs);
+    Parallel::forEach(slabs, [&](size_t slab) {
+            pieces[slab] = piecesOf(*factory_(), points, slabColumns[slab]);
+        });
+
+    // A facet is kept if all other points are above it. These are the
+    // simplices of the serial hull before it merges nearly coplanar ones,
+    // which is done once all of them are found. The backends may have
+    // merged some already, so they are split into simplices again.
+    const PowerLocator locator(points);
+    // Rounding errors are far below this.
+    const double rounding = 1e-3 * tolerance;
+    const auto checkAll = [&](std::vector<PieceFacet>& facets, std::vector<bool>& global,
+            std::vector<size_t>* beyond) {
+        std::vector<std::vector<PieceFacet>> simplices(facets.size());
+        Parallel::forEach(facets.size(), [&](size_t i) {
+                simplices[i] = simplicesOf(facets[i], points, locator, tolerance, rounding);
+            }, 64);
+        facets.clear();
+        for (auto& split : simplices) {
+            std::move(split.begin(), split.end(), std::back_inserter(facets));
+        }
+
+        std::vector<char> result(facets.size());
+        if (beyond != nullptr) {
+            beyond->assign(facets.size(), count);
+        }
+        Parallel::forEach(facets.size(), [&](size_t i) {
+                const auto side = sideOfFacet(facets[i], points, locator, rounding,
+                    beyond != nullptr ? &(*beyond)[i] : nullptr);
+                if (side == Side::Within) {
+                    throw std::runtime_error("Points are coplanar with a facet");
+                }
+                result[i] = side == Side::Above && facets[i].vertices.size() == dimension;
+            }, 64);
+        global.assign(result.begin(), result.end());
+    };
+
+    // Everything near the seams is computed again: the vertices of rejected
+    // facets and of the boundaries of the slabs. Most missing facets have all
+    // of their vertices in there.
+    std::vector<std::vector<bool>> global(slabs);
+    std::vector<bool> isSeam(count, false);
+    for (size_t slab = 0; slab < slabs; ++slab) {
+        checkAll(pieces[slab], global[slab], nullptr);
+
+        for (size_t i = 0; i < pieces[slab].size(); ++i) {
+            const auto& facet = pieces[slab][i];
+            if (!global[slab][i]) {
+                for (auto& vertex : facet.vertices) {
+                    isSeam[vertex] = true;
+                }
+            }
+            for (size_t j = 0; j < facet.ridges.size(); ++j) {
+                if (facet.open[j]) {
+                    for (auto& vertex : facet.ridges[j]) {
+                        isSeam[vertex] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // A missing facet spanning two slabs is a facet of the hull of their
+    // seam points, which are computed for all pairs of neighbouring slabs.
+    std::vector<std::vector<size_t>> seamColumns(slabs - 1);
+    for (size_t seam = 0; seam + 1 < slabs; ++seam) {
+        for (size_t slab = seam; slab < seam + 2; ++slab) {
+            for (auto& column : slabColumns[slab]) {
+                if (isSeam[column]) {
+                    seamColumns[seam].push_back(column);
+                }
+            }
+        }
+    }
+
+    if (FLAGS_verbose) {
+        std::cerr << "Computing the hulls of " << seamColumns.size() << " seams" << std::endl;
+    }
+
+    pieces.resize(slabs + seamColumns.size());
+    global.resize(pieces.size());
+    Parallel::forEach(seamColumns.size(), [&](size_t seam) {
+            pieces[slabs + seam] = piecesOf(*factory_(), points, seamColumns[seam]);
+        });
+    for (size_t piece = slabs; piece < pieces.size(); ++piece) {
+        checkAll(pieces[piece], global[piece], nullptr);
+    }
+
+    // Collect the facets of the whole hull, the pieces repeat some of them,
+    // and return the ridges still missing a facet. All of them are simplices
+    // with the other points above, so they cannot overlap.
+    std::vector<const PieceFacet*> accepted;
+    std::map<std::vector<size_t>, size_t> ridges;
+    const auto collect = [&]() {
+        std::set<std::vector<size_t>> facets;
+        accepted.clear();
+        ridges.clear();
+        for (size_t piece = 0; piece < pieces.size(); ++piece) {
+            for (size_t i = 0; i < pieces[piece].size(); ++i) {
+                const auto& facet = pieces[piece][i];
+                if (!global[piece][i] || !facets.insert(facet.vertices).second) {
+                    continue;
+                }
+
+                accepted.push_back(&facet);
+                for (auto& ridge : facet.ridges) {
+                    if (++ridges[ridge] > 2) {
+                        throw std::runtime_error("The facets of the slabs overlap");
+                    }
+                }
+            }
+        }
+
+        // Every ridge belongs to two facets, unless it is on the boundary.
+        std::set<std::vector<size_t>> open;
+        for (auto& item : ridges) {
+            if (item.second == 1 && !isBoundary(item.first, points, locator, tolerance)) {
+                open.insert(item.first);
+            }
+        }
+        return open;
+    };
+
+    // Facets spanning more slabs lie along the boundary of the projection,
+    // where the lower hull is steep and its facets are long slivers. They
+    // are closed by the hull of a band around the open ridges: it starts
+    // with their vertices and the power-nearest points at them, so it is
+    // full-dimensional, and every rejected facet of its hull at an open
+    // ridge adds the point furthest below it, which is a vertex of the
+    // whole hull, until there are no gaps left.
+    std::vector<bool> isBand(count, false);
+    std::vector<size_t> band;
+    std::vector<size_t> beyond;
+    const auto addToBand = [&](size_t index) {
+        if (index < count && !isBand[index]) {
+            isBand[index] = true;
+            band.push_back(index);
+        }
+    };
+    for (auto open = collect(); !open.empty(); open = collect()) {
+        std::vector<size_t> atOpen;
+        if (!band.empty()) {
+            const auto& facets = pieces.back();
+            for (size_t i = 0; i < facets.size(); ++i) {
+                const bool isAtOpen = std::any_of(facets[i].ridges.begin(), facets[i].ridges.end(),
+                        [&open](const std::vector<size_t>& ridge) { return open.count(ridge) > 0; });
+                if (!global.back()[i] && isAtOpen) {
+                    atOpen.push_back(i);
+                }
+            }
+        }
+
+        const size_t size = band.size();
+        std::vector<size_t> nearest;
+        for (auto& ridge : open) {
+            for (auto& vertex : ridge) {
+                if (!isBand[vertex]) {
+                    locator.nearest(points.col(vertex).head(dimension - 1), dimension + 1, nearest);
+                    addToBand(vertex);
+                    std::for_each(nearest.begin(), nearest.end(), addToBand);
+                }
+            }
+        }
+        for (auto& i : atOpen) {
+            addToBand(beyond[i]);
+        }
+
+        if (band.size() == size) {
+            throw std::runtime_error("The slabs do not fit together");
+        }
+
+        if (FLAGS_verbose) {
+            std::cerr << "Computing the hull of a band of " << band.size() << " points" << std::endl;
+        }
+
+        pieces.push_back(piecesOf(*serial_, points, band));
+        global.emplace_back();
+        checkAll(pieces.back(), global.back(), &beyond);
+    }
+
+    if (FLAGS_verbose) {
+        std::cerr << "Merged the hulls of " << slabs << " slabs" << std::endl;
+    }
+
+    // Link the simplices at their ridges and merge them like the serial
+    // hull does.
+    SimplicialHull<Eigen::Dynamic> hull;
+    std::map<std::vector<size_t>, std::pair<size_t, size_t>> first;
+    for (size_t facet = 0; facet < accepted.size(); ++facet) {
+        const auto& simplex = *accepted[facet];
+        hull.vertices.insert(hull.vertices.end(), simplex.vertices.begin(), simplex.vertices.end());
+        hull.neighbors.resize(hull.vertices.size(), hull.none);
+        hull.normals.push_back(simplex.normal);
+        hull.offsets.push_back(simplex.normal.dot(points.col(simplex.vertices[0])));
+        hull.alive.push_back(true);
+
+        for (size_t i = 0; i < dimension; ++i) {
+            auto ridge = simplex.vertices;
+            ridge.erase(ridge.begin() + i);
+            const auto match = first.find(ridge);
+            if (match == first.end()) {
+                first.insert(std::make_pair(ridge, std::make_pair(facet, i)));
+            } else {
+                const auto other = match->second;
+                hull.neighbors[facet * dimension + i] = other.first;
+                hull.neighbors[other.first * dimension + other.second] = facet;
+            }
+        }
+    }
+
+    return hull.lattice(points, tolerance, Part::Lower, indices);
+}
@@ -0,0 +1,70 @@
+#ifndef CONVEXHULLPARALLEL_H
+#define CONVEXHULLPARALLEL_H
+
+#include "ConvexHullAlgorithm.hpp"
+#include "IncidenceLattice.hpp"
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Lower convex hulls computed slab by slab on all threads.
+ *
+ * The points are split into slabs along the first coordinate and every
+ * slab's lower hull is computed concurrently by its own backend. Its facets
+ * are split into simplices again where the backend merged them. A simplex
+ * of a slab is one of the whole hull if all other points lie above it, which
+ * a PowerLocator answers on the lifted points. The gaps between neighbouring
+ * slabs are closed by the hulls of the vertices near their seam, i.e. those
+ * of rejected simplices and of the slabs' boundaries. Long facets along the
+ * boundary of the projection span more slabs and are closed by the hull of
+ * a band around the ridges still open, which grows by the points below its
+ * rejected simplices.
+ * The simplices found are then merged where they are nearly coplanar, by
+ * the same SimplicialHull step as ConvexHullQuickhull, so the result is the
+ * same as the serial quickhull's. Other backends such as Qhull merge
+ * in their own way, so for nearly cospherical input the result may differ
+ * from their serial hull. powerdiagram only offers this with quickhull. The hull is computed serially if points
+ * are coplanar up to rounding, where the simplices are not unique, or if
+ * the pieces do not fit together.
+ * Other parts than Part::Lower are always computed serially.
+ */
+class ConvexHullParallel : public ConvexHullAlgorithm {
+    public:
+        using Factory_t = std::function<std::unique_ptr<ConvexHullAlgorithm>()>;
+
+        /**
+         * @param factory Creates a backend for every slab, so backends need
+         * not be thread-safe.
+         * @param minSlabSize Inputs are not split into slabs of fewer points.
+         */
+        explicit ConvexHullParallel(Factory_t factory, size_t minSlabSize = 4096) :
+            factory_(factory),
+            serial_(factory()),
+            minSlabSize_(minSlabSize)
+        { }
+        virtual ~ConvexHullParallel() { }
+
+        using ConvexHullAlgorithm::hullOf;
+
+        virtual IncidenceLattice<Eigen::VectorXd> hullOf(
+                const Eigen::MatrixXd& points,
+                Indices_t& indices,
+                Part part);
+
+        virtual double tolerance(const Eigen::MatrixXd& points) const;
+    private:
+        Factory_t factory_;
+        // Used if the points are not split, for the band and for the tolerance.
+        std::unique_ptr<ConvexHullAlgorithm> serial_;
+        size_t minSlabSize_;
+
+        IncidenceLattice<Eigen::VectorXd> mergedHullOf(
+                const Eigen::MatrixXd& points,
+                Indices_t& indices,
+                size_t slabs);
+};
+
+#endif
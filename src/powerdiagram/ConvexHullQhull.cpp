@@ -7,31 +7,24 @@
 #include <libqhullcpp/QhullFacetList.h>
 #include <libqhullcpp/QhullRidge.h>
 #include <libqhullcpp/QhullVertex.h>
-#include <unordered_map>
+#include <type_traits>
 #include <vector>
 
 DEFINE_string(qhullout, "", "Output string for Qhull (e.g. \"f i s\")");
 DECLARE_bool(verbose);
 
-using qhullID_t = int;
 using Eigen::VectorXd;
 
-IncidenceLattice<VectorXd> ConvexHullQhull::hullOf(const std::vector<VectorXd>& points)
+IncidenceLattice<VectorXd> ConvexHullQhull::hullOf(
+        const Eigen::MatrixXd& points,
+        Indices_t& indices,
+        Part part)
 {
-    const size_t dimension = points[0].size();
-
-    // Copy the points to qhull format
-    // We use that std::vector guarantees that its contents are aligned in
-    // memory to avoid dynamic allocation in arrays.
-    // NOTE(mrksr): Copy might not be necessary if we use an Eigen::map<>?
-    std::vector<coordT> qhullpoints;
-    qhullpoints.reserve(dimension * points.size());
-
-    for (size_t i = 0; i < points.size(); ++i) {
-        for (size_t j = 0; j < dimension; ++j) {
-            qhullpoints.push_back(points[i][j]);
-        }
-    }
+    const size_t dimension = points.rows();
+
+    // Qhull expects the coordinates of one point after the other, which is
+    // exactly how Eigen stores the columns, so Qhull can read the matrix.
+    static_assert(std::is_same<coordT, double>::value, "Qhull has to use doubles.");
 
     // Find the convex hull and do some output-handling.
     orgQhull::Qhull qhull;
@@ -41,7 +34,7 @@ IncidenceLattice<VectorXd> ConvexHullQhull::hullOf(const std::vector<VectorXd>&
     if (FLAGS_verbose) {
         std::cerr << "Starting Qhull" << std::endl;
     }
-    qhull.runQhull("", dimension, points.size(), &qhullpoints[0], FLAGS_qhullout.c_str());
+    qhull.runQhull("", dimension, points.cols(), points.data(), FLAGS_qhullout.c_str());
 
     if (!FLAGS_qhullout.empty()) {
         std::cerr << "Qhull Message for parameters: " << FLAGS_qhullout << std::endl;
@@ -53,15 +46,17 @@ IncidenceLattice<VectorXd> ConvexHullQhull::hullOf(const std::vector<VectorXd>&
     }
 
     // Create the incidence lattice
-    IncidenceLattice<VectorXd> lattice;
-    std::unordered_map<qhullID_t, decltype(lattice)::Key_t> vertexMap;
+    IncidenceLattice<VectorXd>::Builder lattice;
+    auto& vertexMap = vertexMap_;
+    vertexMap.clear();
+    indices.clear();
 
     // Add facets and ridges
     const auto facets = qhull.facetList().toStdVector();
     // Bookkeeping to ensure we visit every ridge only once.
     qhull.qhullQh()->visit_id++;
     // Temporary Set
-    decltype(lattice)::Keys_t vertices;
+    IncidenceLattice<VectorXd>::Keys_t vertices;
     // Verbosity Things
     size_t currentFacet = 0;
     const size_t allFacets = facets.size();
@@ -79,19 +74,28 @@ IncidenceLattice<VectorXd> ConvexHullQhull::hullOf(const std::vector<VectorXd>&
         }
         currentFacet++;
 
+        // Qhull's normals point outwards. Skipped facets stay unvisited, so
+        // the ridges between them and the facets we keep are still added.
+        if (part == Part::Lower && facet.getFacetT()->normal[dimension - 1] >= 0) {
+            continue;
+        }
+
         vertices.clear();
 
         // Add the facet
         for (auto& vertex : facet.vertices()) {
             const auto id = vertex.point().id(qhull.runId());
             if (vertexMap.find(id) == vertexMap.end()) {
-                vertexMap[id] = lattice.addMinimal(points[id]);
+                vertexMap[id] = lattice.addMinimal(points.col(id));
+                indices[vertexMap[id]] = id;
             }
 
             vertices.insert(vertexMap[id]);
         }
 
-        lattice.addMaximalFace(vertices);
+        // Qhull's hyperplanes are oriented and normalized already.
+        lattice.value(lattice.addFace(vertices)) =
+            Eigen::Map<const VectorXd>(facet.getFacetT()->normal, dimension);
 
         // Add the ridges
         // See FAQ of qhull about makeridges.
@@ -110,7 +114,8 @@ IncidenceLattice<VectorXd> ConvexHullQhull::hullOf(const std::vector<VectorXd>&
                 for (auto& vertex : ridge.vertices()) {
                     const auto id = vertex.point().id(qhull.runId());
                     if (vertexMap.find(id) == vertexMap.end()) {
-                        vertexMap[id] = lattice.addMinimal(points[id]);
+                        vertexMap[id] = lattice.addMinimal(points.col(id));
+                        indices[vertexMap[id]] = id;
                     }
 
                     vertices.insert(vertexMap[id]);
@@ -121,5 +126,5 @@ IncidenceLattice<VectorXd> ConvexHullQhull::hullOf(const std::vector<VectorXd>&
         }
     }
 
-    return lattice;
+    return lattice.build();
 }
@@ -5,16 +5,28 @@
 #include "IncidenceLattice.hpp"
 
 #include <Eigen/Dense>
+#include <unordered_map>
 #include <vector>
 
+/**
+ * @brief Convex hulls computed by Qhull.
+ * Every call runs a new Qhull. Only the map from Qhull's point ids to the
+ * vertex keys is kept, so it is not allocated again for the next hull.
+ */
 class ConvexHullQhull : public ConvexHullAlgorithm {
     public:
-        ConvexHullQhull() { };
+        ConvexHullQhull() : vertexMap_() { }
         virtual ~ConvexHullQhull() { }
 
+        using ConvexHullAlgorithm::hullOf;
 
-        virtual IncidenceLattice<Eigen::VectorXd> hullOf(const std::vector<Eigen::VectorXd>& points);
+        virtual IncidenceLattice<Eigen::VectorXd> hullOf(
+                const Eigen::MatrixXd& points,
+                Indices_t& indices,
+                Part part);
     private:
+        // Maps the point ids of Qhull to the keys of the vertices.
+        std::unordered_map<int, Lattice_t::Key_t> vertexMap_;
 };
 
 #endif
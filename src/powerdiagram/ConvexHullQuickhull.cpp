@@ -0,0 +1,409 @@
+#include "ConvexHullQuickhull.hpp"
+
+#include "FixedDimension.hpp"
+#include "SimplicialHull.hpp"
+
+#include <gflags/gflags.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+DECLARE_bool(verbose);
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using Lattice_t = IncidenceLattice<VectorXd>;
+
+/**
+ * @brief Quickhull for points of a fixed dimension (or Eigen::Dynamic).
+ */
+template <int Dimension>
+class QuickhullEngine {
+    public:
+        using Point_t = Eigen::Matrix<double, Dimension, 1>;
+
+        static Lattice_t run(
+                const MatrixXd& points,
+                ConvexHullAlgorithm::Indices_t& indices,
+                ConvexHullAlgorithm::Part part,
+                double epsilon)
+        {
+            QuickhullEngine engine(points, epsilon);
+            engine.initialSimplex();
+            engine.expand();
+
+            return engine.lattice(indices, part);
+        }
+
+    private:
+        enum { Reduced = FixedDimension::Reduced<Dimension>::value };
+
+        const MatrixXd& points_;
+        const size_t dimension_;
+        // Points closer to a hyperplane than this are considered to be in it.
+        double epsilon_;
+        // Some point strictly inside of the hull, used to orient the facets.
+        Point_t interior_;
+
+        // Facet f has the vertices vertices_[f * dimension_ + i]. The facet
+        // opposite of vertex i, i.e. sharing all other vertices, is
+        // neighbors_[f * dimension_ + i].
+        std::vector<size_t> vertices_;
+        std::vector<size_t> neighbors_;
+        // Outward unit normals and offsets, a point x is outside of facet f
+        // if normals_[f].dot(x) > offsets_[f].
+        std::vector<Point_t, Eigen::aligned_allocator<Point_t>> normals_;
+        std::vector<double> offsets_;
+        // Points which are outside of a facet, the conflict lists.
+        std::vector<std::vector<size_t>> outside_;
+        std::vector<bool> alive_;
+        // Facets visited in the current search have visited_ == epoch_.
+        std::vector<size_t> visited_;
+        size_t epoch_;
+        // Removed facets whose slots can be reused.
+        std::vector<size_t> free_;
+        // Facets which might have points outside.
+        std::vector<size_t> pending_;
+
+        QuickhullEngine(const MatrixXd& points, double epsilon):
+            points_(points),
+            dimension_(points.rows()),
+            epsilon_(epsilon),
+            interior_(),
+            vertices_(),
+            neighbors_(),
+            normals_(),
+            offsets_(),
+            outside_(),
+            alive_(),
+            visited_(),
+            epoch_(0),
+            free_(),
+            pending_()
+        { }
+
+        Eigen::Map<const Point_t> point(size_t index) const
+        {
+            return Eigen::Map<const Point_t>(points_.data() + index * dimension_, dimension_);
+        }
+        size_t& vertex(size_t facet, size_t i)
+        {
+            return vertices_[facet * dimension_ + i];
+        }
+        size_t& neighbor(size_t facet, size_t i)
+        {
+            return neighbors_[facet * dimension_ + i];
+        }
+        double distance(size_t facet, size_t index) const
+        {
+            return normals_[facet].dot(point(index)) - offsets_[facet];
+        }
+
+        /**
+         * @brief Add a facet with the given vertices and compute its
+         * hyperplane. The neighbors are left to the caller.
+         */
+        size_t createFacet(const std::vector<size_t>& vertices)
+        {
+            size_t facet;
+            if (!free_.empty()) {
+                facet = free_.back();
+                free_.pop_back();
+            } else {
+                facet = alive_.size();
+                vertices_.resize(vertices_.size() + dimension_);
+                neighbors_.resize(neighbors_.size() + dimension_);
+                normals_.emplace_back();
+                offsets_.push_back(0);
+                outside_.emplace_back();
+                alive_.push_back(false);
+                visited_.push_back(0);
+            }
+
+            std::copy(vertices.begin(), vertices.end(), vertices_.begin() + facet * dimension_);
+            alive_[facet] = true;
+            outside_[facet].clear();
+
+            Eigen::Matrix<double, Reduced, Dimension> A;
+            A.resize(dimension_ - 1, dimension_);
+            for (size_t i = 1; i < dimension_; ++i) {
+                A.row(i - 1) = (point(vertices[i]) - point(vertices[0])).transpose();
+            }
+
+            Point_t normal = FixedDimension::kernelOf(A).normalized();
+            double offset = normal.dot(point(vertices[0]));
+            if (normal.dot(interior_) > offset) {
+                normal *= -1;
+                offset *= -1;
+            }
+            normals_[facet] = normal;
+            offsets_[facet] = offset;
+
+            return facet;
+        }
+
+        /**
+         * @brief Build the hull of dimension + 1 affinely independent points
+         * and distribute all others to its conflict lists.
+         */
+        void initialSimplex()
+        {
+            const size_t count = points_.cols();
+            if (count < dimension_ + 1) {
+                throw std::runtime_error("Quickhull: Not enough points for a full-dimensional hull");
+            }
+
+            // Greedily add the point furthest away from the affine hull of
+            // the points chosen so far.
+            std::vector<size_t> simplex(1);
+            Eigen::DenseIndex first;
+            points_.row(0).minCoeff(&first);
+            simplex[0] = first;
+
+            std::vector<Point_t, Eigen::aligned_allocator<Point_t>> basis;
+            while (simplex.size() <= dimension_) {
+                double best = -1;
+                size_t bestIndex = 0;
+                Point_t bestResidual = Point_t::Zero(dimension_);
+                for (size_t i = 0; i < count; ++i) {
+                    Point_t residual = point(i) - point(simplex[0]);
+                    for (auto& direction : basis) {
+                        residual -= direction.dot(residual) * direction;
+                    }
+
+                    const double norm = residual.norm();
+                    if (norm > best) {
+                        best = norm;
+                        bestIndex = i;
+                        bestResidual = residual;
+                    }
+                }
+
+                if (best <= epsilon_) {
+                    throw std::runtime_error("Quickhull: The points are not full-dimensional");
+                }
+                simplex.push_back(bestIndex);
+                basis.push_back(bestResidual / best);
+            }
+
+            interior_ = Point_t::Zero(dimension_);
+            for (auto& index : simplex) {
+                interior_ += point(index);
+            }
+            interior_ /= simplex.size();
+
+            // Facet k leaves out simplex[k], its neighbor opposite of
+            // simplex[m] is facet m.
+            std::vector<size_t> vertices;
+            for (size_t k = 0; k <= dimension_; ++k) {
+                vertices.clear();
+                for (size_t m = 0; m <= dimension_; ++m) {
+                    if (m != k) {
+                        vertices.push_back(simplex[m]);
+                    }
+                }
+                createFacet(vertices);
+            }
+            for (size_t k = 0; k <= dimension_; ++k) {
+                for (size_t i = 0; i < dimension_; ++i) {
+                    neighbor(k, i) = i < k ? i : i + 1;
+                }
+            }
+
+            std::vector<bool> inSimplex(count, false);
+            for (auto& index : simplex) {
+                inSimplex[index] = true;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (inSimplex[i]) {
+                    continue;
+                }
+                for (size_t facet = 0; facet <= dimension_; ++facet) {
+                    if (distance(facet, i) > epsilon_) {
+                        outside_[facet].push_back(i);
+                        break;
+                    }
+                }
+            }
+            for (size_t facet = 0; facet <= dimension_; ++facet) {
+                if (!outside_[facet].empty()) {
+                    pending_.push_back(facet);
+                }
+            }
+        }
+
+        /**
+         * @brief Add the furthest outside points of the facets until no
+         * points are outside any more.
+         */
+        void expand()
+        {
+            std::vector<size_t> visible;
+            std::vector<size_t> created;
+            // Ridges of visible facets with a facet which is not visible,
+            // given by the visible facet and the vertex opposite of the ridge.
+            std::vector<std::pair<size_t, size_t>> horizon;
+            // New ridges waiting for their second facet.
+            std::map<std::vector<size_t>, std::pair<size_t, size_t>> ridges;
+            std::vector<size_t> vertices(dimension_);
+            std::vector<size_t> ridge(dimension_ - 1);
+
+            while (!pending_.empty()) {
+                const size_t start = pending_.back();
+                pending_.pop_back();
+                if (!alive_[start] || outside_[start].empty()) {
+                    continue;
+                }
+
+                const auto& candidates = outside_[start];
+                const size_t apex = *std::max_element(candidates.begin(), candidates.end(),
+                        [this, start](size_t a, size_t b) {
+                            return distance(start, a) < distance(start, b);
+                        });
+
+                // All facets the apex can see form a connected region.
+                ++epoch_;
+                visible.assign(1, start);
+                visited_[start] = epoch_;
+                horizon.clear();
+                for (size_t k = 0; k < visible.size(); ++k) {
+                    const size_t facet = visible[k];
+                    for (size_t i = 0; i < dimension_; ++i) {
+                        const size_t other = neighbor(facet, i);
+                        if (visited_[other] == epoch_) {
+                            continue;
+                        }
+
+                        if (distance(other, apex) > epsilon_) {
+                            visited_[other] = epoch_;
+                            visible.push_back(other);
+                        } else {
+                            horizon.push_back(std::make_pair(facet, i));
+                        }
+                    }
+                }
+
+                // Connect the horizon to the apex. The new facet replaces the
+                // vertex opposite of the horizon ridge by the apex.
+                created.clear();
+                ridges.clear();
+                for (auto& item : horizon) {
+                    const size_t facet = item.first;
+                    const size_t opposite = item.second;
+                    const size_t other = neighbor(facet, opposite);
+
+                    for (size_t i = 0; i < dimension_; ++i) {
+                        vertices[i] = vertex(facet, i);
+                    }
+                    vertices[opposite] = apex;
+
+                    const size_t added = createFacet(vertices);
+                    created.push_back(added);
+                    neighbor(added, opposite) = other;
+                    for (size_t i = 0; i < dimension_; ++i) {
+                        if (neighbor(other, i) == facet) {
+                            neighbor(other, i) = added;
+                        }
+                    }
+
+                    // All other ridges of the new facet contain the apex and
+                    // are shared with another new facet.
+                    for (size_t i = 0; i < dimension_; ++i) {
+                        if (i == opposite) {
+                            continue;
+                        }
+
+                        std::copy(vertices.begin(), vertices.begin() + i, ridge.begin());
+                        std::copy(vertices.begin() + i + 1, vertices.end(), ridge.begin() + i);
+                        std::sort(ridge.begin(), ridge.end());
+
+                        const auto match = ridges.find(ridge);
+                        if (match == ridges.end()) {
+                            ridges.insert(std::make_pair(ridge, std::make_pair(added, i)));
+                        } else {
+                            neighbor(added, i) = match->second.first;
+                            neighbor(match->second.first, match->second.second) = added;
+                            ridges.erase(match);
+                        }
+                    }
+                }
+
+                // Hand the points of the removed facets to the new ones.
+                for (auto& facet : visible) {
+                    for (auto& index : outside_[facet]) {
+                        if (index == apex) {
+                            continue;
+                        }
+
+                        for (auto& added : created) {
+                            if (distance(added, index) > epsilon_) {
+                                outside_[added].push_back(index);
+                                break;
+                            }
+                        }
+                    }
+
+                    alive_[facet] = false;
+                    outside_[facet].clear();
+                    free_.push_back(facet);
+                }
+
+                for (auto& added : created) {
+                    if (!outside_[added].empty()) {
+                        pending_.push_back(added);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Merge the facets in the same hyperplanes and build the
+         * lattice of the (requested part of the) hull from them.
+         */
+        Lattice_t lattice(ConvexHullAlgorithm::Indices_t& indices, ConvexHullAlgorithm::Part part)
+        {
+            SimplicialHull<Dimension> hull;
+            hull.vertices = std::move(vertices_);
+            hull.neighbors = std::move(neighbors_);
+            hull.normals = std::move(normals_);
+            hull.offsets = std::move(offsets_);
+            hull.alive = std::move(alive_);
+
+            return hull.lattice(points_, epsilon_, part, indices);
+        }
+};
+
+IncidenceLattice<VectorXd> ConvexHullQuickhull::hullOf(
+        const MatrixXd& points,
+        Indices_t& indices,
+        Part part)
+{
+    if (FLAGS_verbose) {
+        std::cerr << "Starting Quickhull" << std::endl;
+    }
+
+    // Lifted 2D and 3D spheres
+    const double epsilon = tolerance(points);
+    Lattice_t lattice;
+    switch (points.rows()) {
+        case 3:
+            lattice = QuickhullEngine<3>::run(points, indices, part, epsilon);
+            break;
+        case 4:
+            lattice = QuickhullEngine<4>::run(points, indices, part, epsilon);
+            break;
+        default:
+            lattice = QuickhullEngine<Eigen::Dynamic>::run(points, indices, part, epsilon);
+            break;
+    }
+
+    if (FLAGS_verbose) {
+        std::cerr << "Quickhull is done." << std::endl;
+    }
+
+    return lattice;
+}
@@ -0,0 +1,34 @@
+#ifndef CONVEXHULLQUICKHULL_H
+#define CONVEXHULLQUICKHULL_H
+
+#include "ConvexHullAlgorithm.hpp"
+#include "IncidenceLattice.hpp"
+
+#include <Eigen/Dense>
+#include <vector>
+
+/**
+ * @brief Convex hulls computed by a built-in quickhull.
+ *
+ * The hull is kept as a flat array of simplicial facets with links to their
+ * neighbors. Every facet owns the points outside of it (its conflict list).
+ * The furthest point of such a list is added by removing all facets it can
+ * see and connecting their horizon to it, until no points are left outside.
+ * Neighboring facets in the same hyperplane are merged when building the
+ * lattice, so degenerate input results in the same faces as with Qhull.
+ * 3D and 4D points, i.e. lifted 2D and 3D spheres, use fixed-size vectors.
+ */
+class ConvexHullQuickhull : public ConvexHullAlgorithm {
+    public:
+        ConvexHullQuickhull() { }
+        virtual ~ConvexHullQuickhull() { }
+
+        using ConvexHullAlgorithm::hullOf;
+
+        virtual IncidenceLattice<Eigen::VectorXd> hullOf(
+                const Eigen::MatrixXd& points,
+                Indices_t& indices,
+                Part part);
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef FIXEDDIMENSION_H
+#define FIXEDDIMENSION_H
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief Helpers to run algorithms with the dimension known at compile time.
+ *
+ * An engine is a class template Engine<int Dimension> with a static run
+ * function. Dimension is either one of the specialised dimensions or
+ * Eigen::Dynamic, in which case the engine has to use the runtime dimension.
+ */
+class FixedDimension {
+    public:
+        virtual ~FixedDimension() { }
+
+        /**
+         * @brief Dimension + 1, i.e. the dimension of the space spheres are
+         * lifted to.
+         */
+        template <int Dimension>
+        struct Lifted {
+            enum { value = Dimension == Eigen::Dynamic ? Eigen::Dynamic : Dimension + 1 };
+        };
+
+        /**
+         * @brief Dimension - 1, i.e. the dimension of a hyperplane.
+         */
+        template <int Dimension>
+        struct Reduced {
+            enum { value = Dimension == Eigen::Dynamic ? Eigen::Dynamic : Dimension - 1 };
+        };
+
+        /**
+         * @brief Call Engine<dimension>::run(args...) for the dimensions 2
+         * and 3 and Engine<Eigen::Dynamic>::run(args...) for all others.
+         */
+        template <template <int> class Engine, typename... Args>
+        static auto dispatch(size_t dimension, Args&&... args)
+            -> decltype(Engine<Eigen::Dynamic>::run(std::forward<Args>(args)...))
+        {
+            switch (dimension) {
+                case 2:
+                    return Engine<2>::run(std::forward<Args>(args)...);
+                case 3:
+                    return Engine<3>::run(std::forward<Args>(args)...);
+                default:
+                    return Engine<Eigen::Dynamic>::run(std::forward<Args>(args)...);
+            }
+        }
+
+        /**
+         * @brief A vector spanning the kernel of a matrix with one row less
+         * than columns and full rank.
+         */
+        template <int Rows, int Cols>
+        static Eigen::Matrix<double, Cols, 1> kernelOf(const Eigen::Matrix<double, Rows, Cols>& A)
+        {
+            return A.fullPivLu().kernel().col(0);
+        }
+
+        // For few columns the kernel has a closed form, the (generalized)
+        // cross product of the rows.
+        static Eigen::Vector2d kernelOf(const Eigen::Matrix<double, 1, 2>& A)
+        {
+            return Eigen::Vector2d(-A(0, 1), A(0, 0));
+        }
+        static Eigen::Vector3d kernelOf(const Eigen::Matrix<double, 2, 3>& A)
+        {
+            return A.row(0).cross(A.row(1)).transpose();
+        }
+        static Eigen::Vector4d kernelOf(const Eigen::Matrix<double, 3, 4>& A)
+        {
+            // Cofactor expansion along a fourth row, which is the kernel.
+            Eigen::Vector4d kernel;
+            for (int i = 0; i < 4; ++i) {
+                Eigen::Matrix3d minor;
+                for (int j = 0, column = 0; j < 4; ++j) {
+                    if (j != i) {
+                        minor.col(column++) = A.col(j);
+                    }
+                }
+                kernel[i] = (i % 2 == 0 ? 1 : -1) * minor.determinant();
+            }
+
+            return kernel;
+        }
+
+    private:
+        FixedDimension();
+};
+
+#endif
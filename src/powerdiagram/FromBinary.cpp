@@ -0,0 +1,199 @@
+#include "FromBinary.hpp"
+
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+static const char sphereMagic[8] = {'P', 'D', 'S', 'P', 'H', 'E', 'R', 'E'};
+static const uint32_t byteOrderMark = 0x01020304;
+static const uint32_t version = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t version;
+    uint64_t dimension;
+    uint64_t count;
+};
+static_assert(sizeof(Header) == 32, "The header has to be packed.");
+
+template <typename T>
+static T swapBytes(T value)
+{
+    char* bytes = reinterpret_cast<char*>(&value);
+    std::reverse(bytes, bytes + sizeof(T));
+    return value;
+}
+
+static std::runtime_error binaryError(const char* file, const char* what)
+{
+    return std::runtime_error(std::string(file) + ": " + what);
+}
+
+/**
+ * @brief Copy count doubles from unaligned storage, converting their byte
+ * order if necessary.
+ */
+static void copyDoubles(double* to, const char* from, size_t count, bool swapped)
+{
+    std::memcpy(to, from, count * sizeof(double));
+
+    if (swapped) {
+        std::transform(to, to + count, to, swapBytes<double>);
+    }
+}
+
+bool FromBinary::isBinary(const char* file)
+{
+    static const std::string extension = ".spheres";
+    const std::string name(file);
+
+    return name.size() >= extension.size() &&
+        name.compare(name.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+/**
+ * @brief Read and validate the header of a mapped sphere file.
+ * Throws std::runtime_error if the file is invalid.
+ *
+ * @param swapped Set to whether the file has the other byte order.
+ *
+ * @return The header in native byte order.
+ */
+static Header headerOf(const MappedFile& mapped, const char* file, bool& swapped)
+{
+    Header header;
+    if (mapped.size() < sizeof(header)) {
+        throw binaryError(file, "File too small for a sphere file header");
+    }
+    std::memcpy(&header, mapped.begin(), sizeof(header));
+
+    if (std::memcmp(header.magic, sphereMagic, sizeof(sphereMagic)) != 0) {
+        throw binaryError(file, "Not a sphere file");
+    }
+
+    swapped = header.byteOrder != byteOrderMark;
+    if (swapped) {
+        if (swapBytes(header.byteOrder) != byteOrderMark) {
+            throw binaryError(file, "Invalid byte order mark");
+        }
+
+        header.version = swapBytes(header.version);
+        header.dimension = swapBytes(header.dimension);
+        header.count = swapBytes(header.count);
+    }
+
+    if (header.version != version) {
+        throw binaryError(file, "Unsupported sphere file version");
+    }
+    if (header.count > 0 && header.dimension == 0) {
+        throw binaryError(file, "Spheres need at least one dimension");
+    }
+
+    // Compare by division, so huge counts in a broken header cannot wrap
+    // around into a plausible size.
+    const uint64_t payloadSize = mapped.size() - sizeof(header);
+    const uint64_t values = payloadSize / sizeof(double);
+    if (payloadSize % sizeof(double) != 0 ||
+            header.dimension > static_cast<uint64_t>(std::numeric_limits<Eigen::Index>::max()) ||
+            (header.count == 0 && values != 0) ||
+            (header.count > 0 && (header.dimension >= values ||
+                                  values % (header.dimension + 1) != 0 ||
+                                  values / (header.dimension + 1) != header.count))) {
+        throw binaryError(file, "File size does not match the header");
+    }
+
+    return header;
+}
+
+/**
+ * @brief Copy the payload of a mapped sphere file whose header is valid.
+ */
+static void copySpheres(
+        const MappedFile& mapped,
+        const Header& header,
+        bool swapped,
+        MatrixXd& centerMatrix,
+        VectorXd& radii)
+{
+    centerMatrix.resize(header.dimension, header.count);
+    radii.resize(header.count);
+
+    const char* payload = mapped.begin() + sizeof(header);
+    copyDoubles(centerMatrix.data(), payload, centerMatrix.size(), swapped);
+    payload += centerMatrix.size() * sizeof(double);
+    copyDoubles(radii.data(), payload, radii.size(), swapped);
+}
+
+void FromBinary::read(const char* file, MatrixXd& centerMatrix, VectorXd& radii)
+{
+    const MappedFile mapped(file);
+    bool swapped;
+    const auto header = headerOf(mapped, file, swapped);
+
+    copySpheres(mapped, header, swapped, centerMatrix, radii);
+}
+
+FromBinary::Mapped::Mapped(const char* file):
+    file_(new MappedFile(file)),
+    centerCopy_(),
+    radiusCopy_(),
+    centers_(nullptr),
+    radii_(nullptr),
+    dimension_(0),
+    count_(0)
+{
+    bool swapped;
+    const auto header = headerOf(*file_, file, swapped);
+    dimension_ = header.dimension;
+    count_ = header.count;
+
+    if (swapped) {
+        copySpheres(*file_, header, swapped, centerCopy_, radiusCopy_);
+        file_.reset();
+        centers_ = centerCopy_.data();
+        radii_ = radiusCopy_.data();
+        return;
+    }
+
+    // The header keeps the payload aligned to doubles within the mapping,
+    // which is aligned to pages (or by the allocator).
+    const char* payload = file_->begin() + sizeof(header);
+    centers_ = reinterpret_cast<const double*>(payload);
+    radii_ = centers_ + dimension_ * count_;
+}
+
+void FromBinary::write(const char* file, const MatrixXd& centerMatrix, const VectorXd& radii)
+{
+    assert(centerMatrix.cols() == radii.size() && "Every center needs a radius.");
+
+    Header header;
+    std::memcpy(header.magic, sphereMagic, sizeof(sphereMagic));
+    header.byteOrder = byteOrderMark;
+    header.version = version;
+    header.dimension = centerMatrix.rows();
+    header.count = centerMatrix.cols();
+
+    std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(
+            reinterpret_cast<const char*>(centerMatrix.data()),
+            centerMatrix.size() * sizeof(double));
+    stream.write(
+            reinterpret_cast<const char*>(radii.data()),
+            radii.size() * sizeof(double));
+
+    if (!stream) {
+        throw binaryError(file, "Cannot write sphere file");
+    }
+}
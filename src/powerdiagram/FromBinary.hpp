@@ -0,0 +1,98 @@
+#ifndef FROMBINARY_H
+#define FROMBINARY_H
+
+#include "MappedFile.hpp"
+
+#include <Eigen/Dense>
+#include <memory>
+
+/**
+ * @brief Reads and writes sets of spheres in a compact binary format.
+ *
+ * A file consists of a 32 byte header followed by the payload:
+ *   char[8]  magic "PDSPHERE"
+ *   uint32   byte order mark 0x01020304, written in the writer's byte order
+ *   uint32   format version (currently 1)
+ *   uint64   dimension d
+ *   uint64   number of spheres n
+ *   double   n * d center coordinates, one center after the other
+ *   double   n radii
+ * Files written on a machine with different endianness are converted while
+ * loading.
+ */
+class FromBinary {
+    public:
+        virtual ~FromBinary() { }
+
+        /**
+         * @brief Whether a file name refers to a binary sphere file, i.e.
+         * ends in ".spheres".
+         */
+        static bool isBinary(const char* file);
+
+        /**
+         * @brief Load a binary sphere file into one matrix whose columns are
+         * the centers and a vector of radii.
+         */
+        static void read(
+                const char* file,
+                Eigen::MatrixXd& centerMatrix,
+                Eigen::VectorXd& radii);
+
+        /**
+         * @brief The spheres of a binary sphere file, used in place.
+         *
+         * The centers and radii refer to the memory-mapped file as long as
+         * this exists, so loading only reads the header. Files with the other
+         * byte order are converted into a copy instead.
+         */
+        class Mapped {
+            public:
+                /**
+                 * @brief Map a binary sphere file.
+                 * Throws std::runtime_error if the file is invalid.
+                 */
+                explicit Mapped(const char* file);
+                virtual ~Mapped() { }
+
+                Mapped(const Mapped&) = delete;
+                Mapped& operator=(const Mapped&) = delete;
+
+                /**
+                 * @brief The centers, one per column.
+                 */
+                Eigen::Map<const Eigen::MatrixXd> centers() const
+                {
+                    return Eigen::Map<const Eigen::MatrixXd>(centers_, dimension_, count_);
+                }
+                Eigen::Map<const Eigen::VectorXd> radii() const
+                {
+                    return Eigen::Map<const Eigen::VectorXd>(radii_, count_);
+                }
+
+            private:
+                std::unique_ptr<MappedFile> file_;
+                // Only used if the byte order had to be converted.
+                Eigen::MatrixXd centerCopy_;
+                Eigen::VectorXd radiusCopy_;
+
+                const double* centers_;
+                const double* radii_;
+                Eigen::Index dimension_;
+                Eigen::Index count_;
+        };
+
+        /**
+         * @brief Write spheres given as center columns and radii to a binary
+         * sphere file.
+         */
+        static void write(
+                const char* file,
+                const Eigen::MatrixXd& centerMatrix,
+                const Eigen::VectorXd& radii);
+
+    private:
+        FromBinary();
+};
+
+#endif
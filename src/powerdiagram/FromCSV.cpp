@@ -1,63 +1,629 @@
 #include "FromCSV.hpp"
 
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+
 #include <Eigen/Dense>
-#include <fstream>
-#include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 using Eigen::VectorXd;
 using Eigen::MatrixXd;
 
-VectorXd nextCenter(std::istream& centerStream)
+/**
+ * @brief Walks over the lines of (a part of) a mapped file without copying
+ * them.
+ */
+struct LineReader {
+    LineReader(const char* begin, const char* end, size_t firstLine = 0):
+        pos(begin),
+        end(end),
+        number(firstLine)
+    { }
+    LineReader(const MappedFile& file):
+        LineReader(file.begin(), file.end())
+    { }
+
+    /**
+     * @brief Advance to the next line.
+     *
+     * @param first Set to the first character of the line.
+     * @param last Set past the last character of the line (without '\n').
+     *
+     * @return False if there are no more lines.
+     */
+    bool next(const char*& first, const char*& last)
+    {
+        if (pos == end) {
+            return false;
+        }
+
+        first = pos;
+        const void* newline = std::memchr(pos, '\n', end - pos);
+        last = newline ? static_cast<const char*>(newline) : end;
+        pos = newline ? last + 1 : end;
+        number++;
+
+        return true;
+    }
+
+    const char* pos;
+    const char* end;
+    size_t number;
+};
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool isBlank(const char* first, const char* last)
+{
+    for (; first != last; ++first) {
+        if (!isSpace(*first)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::runtime_error lineError(const char* file, size_t line, const std::string& what)
+{
+    return std::runtime_error(
+            std::string(file) + ":" + std::to_string(line) + ": " + what);
+}
+
+/**
+ * @brief Parse a floating point number at the beginning of [first, last),
+ * similar to std::from_chars.
+ * Numbers with at most 19 significant digits and a small exponent are
+ * converted exactly right here, everything else is handed to strtod through
+ * a buffer on the stack.
+ *
+ * @return Pointer past the parsed number or nullptr if there is none.
+ */
+static const char* parseDouble(const char* first, const char* last, double& value)
+{
+    static const double powersOf10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+
+    const char* pos = first;
+    bool negative = false;
+    if (pos != last && (*pos == '-' || *pos == '+')) {
+        negative = *pos == '-';
+        ++pos;
+    }
+
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+
+    for (; pos != last && isDigit(*pos); ++pos) {
+        anyDigit = true;
+        if (mantissa != 0 || *pos != '0') {
+            significant++;
+        }
+        if (significant <= 19) {
+            mantissa = 10 * mantissa + (*pos - '0');
+        }
+    }
+    if (pos != last && *pos == '.') {
+        ++pos;
+        for (; pos != last && isDigit(*pos); ++pos) {
+            anyDigit = true;
+            if (mantissa != 0 || *pos != '0') {
+                significant++;
+            }
+            if (significant <= 19) {
+                mantissa = 10 * mantissa + (*pos - '0');
+                exponent--;
+            }
+        }
+    }
+    if (!anyDigit) {
+        return nullptr;
+    }
+
+    // The exponent is only part of the number if it contains digits.
+    if (pos != last && (*pos == 'e' || *pos == 'E')) {
+        const char* expPos = pos + 1;
+        bool expNegative = false;
+        if (expPos != last && (*expPos == '-' || *expPos == '+')) {
+            expNegative = *expPos == '-';
+            ++expPos;
+        }
+
+        if (expPos != last && isDigit(*expPos)) {
+            int expValue = 0;
+            for (; expPos != last && isDigit(*expPos); ++expPos) {
+                if (expValue < 100000) {
+                    expValue = 10 * expValue + (*expPos - '0');
+                }
+            }
+            exponent += expNegative ? -expValue : expValue;
+            pos = expPos;
+        }
+    }
+
+    // Both the mantissa and the power of ten are exact doubles here, so a
+    // single multiplication or division rounds correctly.
+    if (significant <= 19 && mantissa <= (uint64_t(1) << 53) &&
+            exponent >= -22 && exponent <= 22) {
+        value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / powersOf10[-exponent] : value * powersOf10[exponent];
+        if (negative) {
+            value = -value;
+        }
+    } else {
+        char buffer[128];
+        const size_t length = pos - first;
+        if (length < sizeof(buffer)) {
+            std::memcpy(buffer, first, length);
+            buffer[length] = '\0';
+            value = std::strtod(buffer, nullptr);
+        } else {
+            value = std::strtod(std::string(first, pos).c_str(), nullptr);
+        }
+    }
+
+    return pos;
+}
+
+/**
+ * @brief Parse a single cell, which must contain one number surrounded by
+ * optional whitespace.
+ */
+static double parseCell(const char* first, const char* last, const char* file, size_t line)
 {
-    // Yes, this is actually ugly.
-    std::string line;
-    std::getline(centerStream, line);
+    while (first != last && isSpace(*first)) {
+        ++first;
+    }
+    while (first != last && isSpace(*(last - 1))) {
+        --last;
+    }
+
+    double value = 0;
+    const char* end = parseDouble(first, last, value);
+    if (end != last || first == last) {
+        throw lineError(file, line, "Invalid number '" + std::string(first, last) + "'");
+    }
+
+    return value;
+}
+
+static size_t cellsIn(const char* first, const char* last)
+{
+    return 1 + std::count(first, last, ',');
+}
 
-    std::istringstream lineStream(line);
-    std::string cell;
+/**
+ * @brief Parse the dimension many comma separated coordinates of a line
+ * whose number of cells has already been checked.
+ */
+static void parseCenter(
+        const char* first,
+        const char* last,
+        size_t dimension,
+        double* center,
+        const char* file,
+        size_t line)
+{
+    for (size_t i = 0; i < dimension; ++i) {
+        const char* cellLast = static_cast<const char*>(
+                std::memchr(first, ',', last - first));
+        if (cellLast == nullptr) {
+            cellLast = last;
+        }
 
-    std::vector<double> entries;
-    double value;
-    while (std::getline(lineStream,cell,',')) {
-        std::istringstream cellStream(cell);
-        cellStream >> value;
-        entries.push_back(value);
+        center[i] = parseCell(first, cellLast, file, line);
+        first = cellLast + 1;
     }
+}
 
-    VectorXd result(entries.size());
-    for (size_t i = 0; i < entries.size(); ++i) {
-        result[i] = entries[i];
+/**
+ * @brief Check that a line of the centers and the line with the same number
+ * of the radii are either both empty or both non-empty.
+ *
+ * @param hasCenter Whether the centers have a line with this number at all.
+ * @param hasRadius Whether the radii have a line with this number at all.
+ *
+ * @return Whether the lines describe a sphere.
+ */
+static bool isSphereLine(
+        bool hasCenter,
+        bool centerBlank,
+        bool hasRadius,
+        bool radiusBlank,
+        size_t line,
+        const char* centers,
+        const char* radiuss)
+{
+    if (centerBlank && radiusBlank) {
+        return false;
+    } else if (centerBlank) {
+        throw lineError(radiuss, line,
+                "Radius without center in " + std::string(centers) +
+                (hasCenter ? "" : " (mismatched line counts)"));
+    } else if (radiusBlank) {
+        throw lineError(centers, line,
+                "Center without radius in " + std::string(radiuss) +
+                (hasRadius ? "" : " (mismatched line counts)"));
     }
-    return result;
+
+    return true;
 }
 
-double nextRadius(std::istream& radiusStream)
+/**
+ * @brief Check that every non-empty line of the centers has a radius in the
+ * same line and vice versa, and that all centers have the same dimension.
+ *
+ * @return The number of spheres.
+ */
+static size_t countSpheres(
+        const MappedFile& centerFile,
+        const MappedFile& radiusFile,
+        const char* centers,
+        const char* radiuss,
+        size_t& dimension)
 {
-    std::string line;
-    std::getline(radiusStream, line);
+    LineReader centerLines(centerFile);
+    LineReader radiusLines(radiusFile);
+    const char *centerFirst = nullptr, *centerLast = nullptr;
+    const char *radiusFirst = nullptr, *radiusLast = nullptr;
+
+    size_t count = 0;
+    dimension = 0;
+    while (true) {
+        const bool hasCenter = centerLines.next(centerFirst, centerLast);
+        const bool hasRadius = radiusLines.next(radiusFirst, radiusLast);
+        if (!hasCenter && !hasRadius) {
+            break;
+        }
+
+        const bool centerBlank = !hasCenter || isBlank(centerFirst, centerLast);
+        const bool radiusBlank = !hasRadius || isBlank(radiusFirst, radiusLast);
+        const auto line = std::max(centerLines.number, radiusLines.number);
+        if (!isSphereLine(hasCenter, centerBlank, hasRadius, radiusBlank, line, centers, radiuss)) {
+            continue;
+        }
 
-    std::istringstream lineStream(line);
-    double result;
-    lineStream >> result;
-    return result;
+        const auto cells = cellsIn(centerFirst, centerLast);
+        if (count == 0) {
+            dimension = cells;
+        } else if (cells != dimension) {
+            throw lineError(centers, centerLines.number,
+                    "Expected " + std::to_string(dimension) +
+                    " coordinates, found " + std::to_string(cells));
+        }
+        if (cellsIn(radiusFirst, radiusLast) != 1) {
+            throw lineError(radiuss, radiusLines.number, "Expected a single radius");
+        }
+
+        count++;
+    }
+
+    return count;
 }
 
-std::vector<PowerDiagram::Sphere_t> FromCSV::spheres(const char* centers, const char* radiuss)
+/**
+ * @brief Parse the spheres validated by countSpheres into preallocated
+ * storage.
+ */
+static void parseSpheres(
+        const MappedFile& centerFile,
+        const MappedFile& radiusFile,
+        const char* centers,
+        const char* radiuss,
+        MatrixXd& centerMatrix,
+        VectorXd& radii)
 {
-    std::vector<PowerDiagram::Sphere_t> spheres;
+    LineReader centerLines(centerFile);
+    LineReader radiusLines(radiusFile);
+    const char *centerFirst = nullptr, *centerLast = nullptr;
+    const char *radiusFirst = nullptr, *radiusLast = nullptr;
+
+    size_t index = 0;
+    while (centerLines.next(centerFirst, centerLast) &&
+            radiusLines.next(radiusFirst, radiusLast)) {
+        if (isBlank(centerFirst, centerLast)) {
+            continue;
+        }
 
-    std::ifstream centerStream(centers);
-    std::ifstream radiusStream(radiuss);
+        parseCenter(
+                centerFirst,
+                centerLast,
+                centerMatrix.rows(),
+                centerMatrix.col(index).data(),
+                centers,
+                centerLines.number);
+        radii[index] = parseCell(radiusFirst, radiusLast, radiuss, radiusLines.number);
 
-    while (centerStream.good() && radiusStream.good()) {
-        auto center = nextCenter(centerStream);
-        auto radius = nextRadius(radiusStream);
+        index++;
+    }
+}
+
+/**
+ * @brief A part of a mapped file which starts at the beginning of a line and
+ * ends after a line break or at the end of the file.
+ */
+struct Chunk {
+    const char* begin;
+    const char* end;
+    // Number of lines before the chunk and within the chunk.
+    size_t firstLine;
+    size_t lines;
+};
+
+/**
+ * @brief Split a file into about parts many newline-aligned chunks and count
+ * their lines in parallel.
+ *
+ * @return The chunks, the last of which ends at the end of the file.
+ */
+static std::vector<Chunk> chunksOf(const MappedFile& file, size_t parts)
+{
+    std::vector<Chunk> chunks;
+    const size_t step = std::max<size_t>(file.size() / parts, 1);
+
+    const char* begin = file.begin();
+    while (begin != file.end()) {
+        const char* end = begin + std::min<size_t>(step, file.end() - begin);
+        const void* newline = std::memchr(end - 1, '\n', file.end() - (end - 1));
+        end = newline ? static_cast<const char*>(newline) + 1 : file.end();
+
+        chunks.push_back(Chunk{begin, end, 0, 0});
+        begin = end;
+    }
+
+    Parallel::forEach(chunks.size(), [&chunks](size_t i) {
+            auto& chunk = chunks[i];
+            chunk.lines = std::count(chunk.begin, chunk.end, '\n');
+            if (*(chunk.end - 1) != '\n') {
+                chunk.lines++;
+            }
+        });
+
+    size_t lines = 0;
+    for (auto& chunk : chunks) {
+        chunk.firstLine = lines;
+        lines += chunk.lines;
+    }
+
+    return chunks;
+}
+
+static size_t linesIn(const std::vector<Chunk>& chunks)
+{
+    return chunks.empty() ? 0 : chunks.back().firstLine + chunks.back().lines;
+}
+
+/**
+ * @brief Find the dimension of the first non-empty line, which all other
+ * lines have to match.
+ */
+static size_t dimensionOf(const MappedFile& file)
+{
+    LineReader lines(file);
+    const char *first = nullptr, *last = nullptr;
+
+    while (lines.next(first, last)) {
+        if (!isBlank(first, last)) {
+            return cellsIn(first, last);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Parse every line of the centers file into the column with the same
+ * number, chunk by chunk on all threads.
+ *
+ * @param blank Set to whether each line is empty.
+ */
+static void parseCenterLines(
+        const MappedFile& file,
+        const char* centers,
+        size_t dimension,
+        MatrixXd& values,
+        std::vector<char>& blank)
+{
+    const auto chunks = chunksOf(file, 4 * Parallel::threads());
+    values.resize(dimension, linesIn(chunks));
+    blank.resize(linesIn(chunks));
+
+    Parallel::forEach(chunks.size(), [&](size_t i) {
+            LineReader lines(chunks[i].begin, chunks[i].end, chunks[i].firstLine);
+            const char *first = nullptr, *last = nullptr;
+
+            while (lines.next(first, last)) {
+                const auto index = lines.number - 1;
+                blank[index] = isBlank(first, last);
+                if (blank[index]) {
+                    continue;
+                }
+
+                const auto cells = cellsIn(first, last);
+                if (cells != dimension) {
+                    throw lineError(centers, lines.number,
+                            "Expected " + std::to_string(dimension) +
+                            " coordinates, found " + std::to_string(cells));
+                }
+
+                parseCenter(first, last, dimension, values.col(index).data(), centers, lines.number);
+            }
+        });
+}
+
+/**
+ * @brief Parse every line of the radii file into the entry with the same
+ * number, chunk by chunk on all threads.
+ *
+ * @param blank Set to whether each line is empty.
+ */
+static void parseRadiusLines(
+        const MappedFile& file,
+        const char* radiuss,
+        VectorXd& values,
+        std::vector<char>& blank)
+{
+    const auto chunks = chunksOf(file, 4 * Parallel::threads());
+    values.resize(linesIn(chunks));
+    blank.resize(linesIn(chunks));
+
+    Parallel::forEach(chunks.size(), [&](size_t i) {
+            LineReader lines(chunks[i].begin, chunks[i].end, chunks[i].firstLine);
+            const char *first = nullptr, *last = nullptr;
+
+            while (lines.next(first, last)) {
+                const auto index = lines.number - 1;
+                blank[index] = isBlank(first, last);
+                if (blank[index]) {
+                    continue;
+                }
 
-        if (center.size() > 0) {
-            spheres.push_back(PowerDiagram::sphere(center, radius));
+                if (cellsIn(first, last) != 1) {
+                    throw lineError(radiuss, lines.number, "Expected a single radius");
+                }
+
+                values[index] = parseCell(first, last, radiuss, lines.number);
+            }
+        });
+}
+
+/**
+ * @brief Parse both files in newline-aligned chunks on all threads and
+ * stitch the lines together in input order afterwards.
+ */
+static void readParallel(
+        const MappedFile& centerFile,
+        const MappedFile& radiusFile,
+        const char* centers,
+        const char* radiuss,
+        MatrixXd& centerMatrix,
+        VectorXd& radii)
+{
+    const auto dimension = dimensionOf(centerFile);
+
+    MatrixXd centerLines;
+    VectorXd radiusLines;
+    std::vector<char> centerBlank, radiusBlank;
+    parseCenterLines(centerFile, centers, dimension, centerLines, centerBlank);
+    parseRadiusLines(radiusFile, radiuss, radiusLines, radiusBlank);
+
+    const size_t lines = std::max(centerBlank.size(), radiusBlank.size());
+    size_t count = 0;
+    for (size_t i = 0; i < lines; ++i) {
+        const bool hasCenter = i < centerBlank.size();
+        const bool hasRadius = i < radiusBlank.size();
+        count += isSphereLine(
+                hasCenter,
+                !hasCenter || centerBlank[i],
+                hasRadius,
+                !hasRadius || radiusBlank[i],
+                i + 1,
+                centers,
+                radiuss);
+    }
+
+    if (count == centerBlank.size() && count == radiusBlank.size()) {
+        // No empty lines, the common case.
+        centerMatrix.swap(centerLines);
+        radii.swap(radiusLines);
+    } else {
+        centerMatrix.resize(dimension, count);
+        radii.resize(count);
+
+        size_t index = 0;
+        for (size_t i = 0; i < centerBlank.size(); ++i) {
+            if (!centerBlank[i]) {
+                centerMatrix.col(index) = centerLines.col(i);
+                radii[index] = radiusLines[i];
+                index++;
+            }
+        }
+    }
+}
+
+void FromCSV::read(
+        const char* centers,
+        const char* radiuss,
+        MatrixXd& centerMatrix,
+        VectorXd& radii,
+        bool parallel)
+{
+    const MappedFile centerFile(centers);
+    const MappedFile radiusFile(radiuss);
+
+    if (parallel) {
+        readParallel(centerFile, radiusFile, centers, radiuss, centerMatrix, radii);
+        return;
+    }
+
+    size_t dimension;
+    const auto count = countSpheres(centerFile, radiusFile, centers, radiuss, dimension);
+
+    centerMatrix.resize(dimension, count);
+    radii.resize(count);
+    parseSpheres(centerFile, radiusFile, centers, radiuss, centerMatrix, radii);
+}
+
+void FromCSV::points(const char* file, MatrixXd& points)
+{
+    const MappedFile mapped(file);
+    const auto dimension = dimensionOf(mapped);
+    const char *first = nullptr, *last = nullptr;
+
+    size_t count = 0;
+    LineReader lines(mapped);
+    while (lines.next(first, last)) {
+        if (isBlank(first, last)) {
+            continue;
         }
+
+        const auto cells = cellsIn(first, last);
+        if (cells != dimension) {
+            throw lineError(file, lines.number,
+                    "Expected " + std::to_string(dimension) +
+                    " coordinates, found " + std::to_string(cells));
+        }
+        count++;
+    }
+
+    points.resize(dimension, count);
+
+    size_t index = 0;
+    lines = LineReader(mapped);
+    while (lines.next(first, last)) {
+        if (!isBlank(first, last)) {
+            parseCenter(first, last, dimension, points.col(index).data(), file, lines.number);
+            index++;
+        }
+    }
+}
+
+std::vector<PowerDiagram::Sphere_t> FromCSV::spheres(
+        const char* centers,
+        const char* radiuss,
+        bool parallel)
+{
+    MatrixXd centerMatrix;
+    VectorXd radii;
+    read(centers, radiuss, centerMatrix, radii, parallel);
+
+    std::vector<PowerDiagram::Sphere_t> spheres;
+    spheres.reserve(radii.size());
+    for (int i = 0; i < radii.size(); ++i) {
+        spheres.push_back(PowerDiagram::sphere(centerMatrix.col(i), radii[i]));
     }
 
     return spheres;
@@ -3,6 +3,7 @@
 
 #include "PowerDiagram.hpp"
 
+#include <Eigen/Dense>
 #include <vector>
 
 class FromCSV {
@@ -11,13 +12,39 @@ class FromCSV {
 
         /**
          * @brief Parse spheres from two files containing centers and radii.
+         * Throws std::runtime_error describing the offending line if the
+         * files cannot be read, contain invalid numbers, have rows of
+         * different lengths or differ in their number of lines.
          *
          * @param centers Name of the file containing the centers.
          * @param radiuss Name of the file containing the radii.
+         * @param parallel Split both files into newline-aligned chunks and
+         * parse them on all threads (see --threads).
          *
          * @return A vector of spheres.
          */
-        static std::vector<PowerDiagram::Sphere_t> spheres(const char* centers, const char* radiuss);
+        static std::vector<PowerDiagram::Sphere_t> spheres(
+                const char* centers,
+                const char* radiuss,
+                bool parallel = false);
+
+        /**
+         * @brief Parse the two files like spheres(), but store the result in
+         * one matrix whose columns are the centers and a vector of radii.
+         * Apart from these two results, nothing is allocated while parsing.
+         */
+        static void read(
+                const char* centers,
+                const char* radiuss,
+                Eigen::MatrixXd& centerMatrix,
+                Eigen::VectorXd& radii,
+                bool parallel = false);
+
+        /**
+         * @brief Parse a single file of points, one per line, into the
+         * columns of a matrix. Empty lines are skipped.
+         */
+        static void points(const char* file, Eigen::MatrixXd& points);
 
     private:
         FromCSV();
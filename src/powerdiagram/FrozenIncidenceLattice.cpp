@@ -0,0 +1,117 @@
+#include "FrozenIncidenceLattice.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using Eigen::VectorXd;
+using Lattice_t = IncidenceLattice<VectorXd>;
+
+FrozenIncidenceLattice::FrozenIncidenceLattice(const Lattice_t& lattice):
+    values_(),
+    valueOffsets_(),
+    predecessors_(),
+    successors_(),
+    minimals_(),
+    minimalFaces_(),
+    maximalFaces_()
+{
+    std::vector<Lattice_t::Key_t> keys;
+    keys.reserve(lattice.size());
+    lattice.forEachFace([&keys](const Lattice_t::Key_t& key) {
+            keys.push_back(key);
+        });
+    std::sort(keys.begin(), keys.end());
+
+    const size_t limit = std::numeric_limits<uint32_t>::max();
+    if (keys.size() >= limit) {
+        throw std::runtime_error("The lattice has too many faces to be frozen");
+    }
+
+    // Keys of the original lattice are below its next key, but not dense.
+    std::vector<Key_t> frozenKey(keys.empty() ? 0 : keys.back() + 1);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        frozenKey[keys[i]] = i;
+    }
+
+    // Sets of the original lattice are sorted and renumbering keeps the
+    // order, so the ranges stay sorted.
+    const auto append = [&frozenKey, limit](Adjacency& adjacency, const Lattice_t::Keys_t& faces) {
+        for (auto face : faces) {
+            adjacency.keys.push_back(frozenKey[face]);
+        }
+        if (adjacency.keys.size() >= limit) {
+            throw std::runtime_error("The lattice has too many incidences to be frozen");
+        }
+        adjacency.offsets.push_back(adjacency.keys.size());
+    };
+
+    valueOffsets_.reserve(keys.size() + 1);
+    valueOffsets_.push_back(0);
+    for (auto adjacency : {&predecessors_, &successors_, &minimals_}) {
+        adjacency->offsets.reserve(keys.size() + 1);
+        adjacency->offsets.push_back(0);
+    }
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const auto& value = lattice.value(keys[i]);
+        values_.insert(values_.end(), value.data(), value.data() + value.size());
+        if (values_.size() >= limit) {
+            throw std::runtime_error("The lattice has too many coordinates to be frozen");
+        }
+        valueOffsets_.push_back(values_.size());
+
+        append(predecessors_, lattice.predecessors(keys[i]));
+        append(successors_, lattice.successors(keys[i]));
+        append(minimals_, lattice.minimalsOf(keys[i]));
+
+        if (lattice.isMinimal(keys[i])) {
+            minimalFaces_.push_back(i);
+        }
+        if (lattice.isMaximal(keys[i])) {
+            maximalFaces_.push_back(i);
+        }
+    }
+
+    values_.shrink_to_fit();
+    for (auto adjacency : {&predecessors_, &successors_, &minimals_}) {
+        adjacency->keys.shrink_to_fit();
+    }
+}
+
+std::vector<FrozenIncidenceLattice::Key_t> FrozenIncidenceLattice::maximalsOf(const Key_t& key) const
+{
+    //NOTE: As in BidirectionalGraph, the buffers are per thread, so
+    //concurrent searches are fine. Only the visited marks are reset.
+    static thread_local std::vector<bool> visited;
+    static thread_local std::vector<Key_t> tovisit;
+    if (visited.size() < size()) {
+        visited.resize(size(), false);
+    }
+    tovisit.clear();
+
+    tovisit.push_back(key);
+    visited[key] = true;
+
+    std::vector<Key_t> result;
+    for (size_t i = 0; i < tovisit.size(); ++i) {
+        const auto element = tovisit[i];
+        if (isMaximal(element)) {
+            result.push_back(element);
+        }
+
+        for (auto& item : successors(element)) {
+            if (!visited[item]) {
+                tovisit.push_back(item);
+                visited[item] = true;
+            }
+        }
+    }
+
+    for (auto& element : tovisit) {
+        visited[element] = false;
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
@@ -0,0 +1,130 @@
+#ifndef FROZENINCIDENCELATTICE_H
+#define FROZENINCIDENCELATTICE_H
+
+#include "IncidenceLattice.hpp"
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief A read-only, compact copy of an IncidenceLattice.
+ *
+ * Faces are renumbered densely in the order of their keys in the original
+ * lattice, so iterating keys yields the same order as before. Predecessors,
+ * successors and minimals of all faces are stored in three CSR arrays of
+ * 32-bit keys and the values of all faces in one contiguous buffer, instead
+ * of three trees and a heap vector per face.
+ *
+ * A frozen lattice is copied from a complete mutable one, so the peak memory
+ * of computing a diagram stays the same, and is even raised by the copy
+ * while both exist. It only helps callers that keep diagrams around after
+ * computing them, or traverse them many times.
+ */
+class FrozenIncidenceLattice {
+    public:
+        using Key_t = uint32_t;
+
+        /**
+         * @brief A sorted range of keys inside the lattice.
+         */
+        class Keys_t {
+            public:
+                Keys_t(const Key_t* begin, const Key_t* end):
+                    begin_(begin),
+                    end_(end)
+                { }
+
+                const Key_t* begin() const
+                {
+                    return begin_;
+                }
+                const Key_t* end() const
+                {
+                    return end_;
+                }
+                size_t size() const
+                {
+                    return end_ - begin_;
+                }
+                bool empty() const
+                {
+                    return begin_ == end_;
+                }
+
+            private:
+                const Key_t* begin_;
+                const Key_t* end_;
+        };
+
+        explicit FrozenIncidenceLattice(const IncidenceLattice<Eigen::VectorXd>& lattice);
+        virtual ~FrozenIncidenceLattice() { }
+
+        size_t size() const
+        {
+            return valueOffsets_.size() - 1;
+        }
+
+        Eigen::Map<const Eigen::VectorXd> value(const Key_t& key) const
+        {
+            return Eigen::Map<const Eigen::VectorXd>(
+                    values_.data() + valueOffsets_[key],
+                    valueOffsets_[key + 1] - valueOffsets_[key]);
+        }
+
+        Keys_t predecessors(const Key_t& key) const
+        {
+            return predecessors_.of(key);
+        }
+        Keys_t successors(const Key_t& key) const
+        {
+            return successors_.of(key);
+        }
+        Keys_t minimals() const
+        {
+            return Keys_t(minimalFaces_.data(), minimalFaces_.data() + minimalFaces_.size());
+        }
+        Keys_t maximals() const
+        {
+            return Keys_t(maximalFaces_.data(), maximalFaces_.data() + maximalFaces_.size());
+        }
+
+        Keys_t minimalsOf(const Key_t& key) const
+        {
+            return minimals_.of(key);
+        }
+        std::vector<Key_t> maximalsOf(const Key_t& key) const;
+        bool isMinimal(const Key_t& key) const
+        {
+            return predecessors(key).empty();
+        }
+        bool isMaximal(const Key_t& key) const
+        {
+            return successors(key).empty();
+        }
+
+    private:
+        /**
+         * @brief Sorted lists of keys for every face, stored back to back.
+         */
+        struct Adjacency {
+            std::vector<uint32_t> offsets;
+            std::vector<Key_t> keys;
+
+            Keys_t of(const Key_t& key) const
+            {
+                return Keys_t(keys.data() + offsets[key], keys.data() + offsets[key + 1]);
+            }
+        };
+
+        std::vector<double> values_;
+        std::vector<uint32_t> valueOffsets_;
+        Adjacency predecessors_;
+        Adjacency successors_;
+        Adjacency minimals_;
+        std::vector<Key_t> minimalFaces_;
+        std::vector<Key_t> maximalFaces_;
+};
+
+#endif
@@ -5,11 +5,18 @@
 
 #include <algorithm>
 #include <cassert>
+#include <numeric>
 #include <queue>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 /**
  * @brief A datastructure containing incidences of faces in a d-dimensional polyhedron.
  *
+ * The sets of minimals and maximals are updated on every change, so they do
+ * not have to be searched for.
+ *
  * @tparam Value_t Type describing the faces, probably a vector.
  */
 template <typename Value_t>
@@ -24,6 +31,19 @@ class IncidenceLattice {
         { }
         virtual ~IncidenceLattice() { }
 
+        size_t size() const
+        {
+            return rep_.size();
+        }
+        /**
+         * @brief Call function with the key of every face, in no particular order.
+         */
+        template <typename Function>
+        void forEachFace(Function&& function) const
+        {
+            rep_.forEachNode(std::forward<Function>(function));
+        }
+
         Value_t& value(const Key_t& key)
         {
             return std::get<0>(rep_.value(key));
@@ -41,11 +61,11 @@ class IncidenceLattice {
         {
             return rep_.successors(key);
         }
-        Keys_t minimals() const
+        const Keys_t& minimals() const
         {
             return rep_.minimalElements();
         }
-        Keys_t maximals() const
+        const Keys_t& maximals() const
         {
             return rep_.maximalElements();
         }
@@ -68,33 +88,27 @@ class IncidenceLattice {
             return rep_.isMaximal(key);
         }
 
+        /**
+         * @brief Keep only the faces below any of the given maximals.
+         */
         void restrictToMaximals(const Keys_t& maximals)
         {
-            rep_.restrictTo([&maximals, this](const Key_t& k) {
-                    const auto succs = maximalsOf(k);
-                    Keys_t intersection;
-                    std::set_intersection(
-                        maximals.begin(),
-                        maximals.end(),
-                        succs.begin(),
-                        succs.end(),
-                        std::inserter(intersection, intersection.begin()));
-                    return !intersection.empty();
-                    });
+            const auto kept = reachableFrom(
+                    maximals,
+                    [this](const Key_t& k) { return isMaximal(k); },
+                    [this](const Key_t& k) -> const Keys_t& { return predecessors(k); });
+            restrictTo(kept);
         }
+        /**
+         * @brief Keep only the faces above any of the given minimals.
+         */
         void restrictToMinimals(const Keys_t& minimals)
         {
-            rep_.restrictTo([&minimals, this](const Key_t& k) {
-                    const auto& preds = minimalsOf(k);
-                    Keys_t intersection;
-                    std::set_intersection(
-                        minimals.begin(),
-                        minimals.end(),
-                        preds.begin(),
-                        preds.end(),
-                        std::inserter(intersection, intersection.begin()));
-                    return !intersection.empty();
-                    });
+            const auto kept = reachableFrom(
+                    minimals,
+                    [this](const Key_t& k) { return isMinimal(k); },
+                    [this](const Key_t& k) -> const Keys_t& { return successors(k); });
+            restrictTo(kept);
         }
 
         /**
@@ -137,6 +151,196 @@ class IncidenceLattice {
             return addFace(faces, true);
         }
 
+        /**
+         * @brief Remove a face together with its incidences.
+         * Faces above or below it are kept, so to keep the lattice
+         * consistent, only maximal faces (or minimals without successors)
+         * should be removed.
+         */
+        void removeFace(const Key_t& key)
+        {
+            rep_.deleteNode(key);
+        }
+
+        /**
+         * @brief Builds a lattice from all of its faces at once.
+         *
+         * Faces are given by their minimals and get the same keys as with
+         * addMinimal and addFace on an empty lattice, but instead of two
+         * BFS per face, duplicates are found by hashing the minimals and all
+         * edges are derived in one pass by build(): a face is covered by
+         * the smallest faces containing it, which all contain its minimal
+         * with the fewest faces.
+         */
+        class Builder {
+            public:
+                Builder():
+                    values_(),
+                    minimals_(),
+                    faces_(0, Hash{this}, Equal{this})
+                { }
+
+                Builder(const Builder&) = delete;
+                Builder& operator=(const Builder&) = delete;
+
+                /**
+                 * @brief Add a new minimal element, i.e. a new vertex.
+                 *
+                 * @return Key of the added vertex.
+                 */
+                Key_t addMinimal(const Value_t& value)
+                {
+                    const Key_t key = values_.size();
+                    values_.push_back(value);
+                    minimals_.push_back(Keys_t{key});
+
+                    return key;
+                }
+
+                /**
+                 * @brief Add any face, maximal or not, unless it exists.
+                 *
+                 * @param minimals Keys of the vertices of the face.
+                 *
+                 * @return Key of the (possibly existing) face.
+                 */
+                Key_t addFace(const Keys_t& minimals)
+                {
+                    assert(!minimals.empty() && "Cannot add the empty face.");
+                    if (minimals.size() == 1) {
+                        return *minimals.begin();
+                    }
+
+                    const Key_t key = values_.size();
+                    minimals_.push_back(minimals);
+                    const auto inserted = faces_.insert(key);
+                    if (!inserted.second) {
+                        minimals_.pop_back();
+                        return *inserted.first;
+                    }
+
+                    values_.emplace_back();
+                    return key;
+                }
+
+                Value_t& value(const Key_t& key)
+                {
+                    return values_[key];
+                }
+
+                /**
+                 * @brief Create the lattice of all added faces. The builder
+                 * is left empty.
+                 */
+                IncidenceLattice build()
+                {
+                    const size_t count = values_.size();
+
+                    // The faces containing every minimal, except itself.
+                    std::vector<size_t> offsets(count + 1, 0);
+                    for (size_t key = 0; key < count; ++key) {
+                        if (minimals_[key].size() > 1) {
+                            for (auto minimal : minimals_[key]) {
+                                ++offsets[minimal + 1];
+                            }
+                        }
+                    }
+                    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+                    std::vector<Key_t> containing(offsets.back());
+                    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+                    for (size_t key = 0; key < count; ++key) {
+                        if (minimals_[key].size() > 1) {
+                            for (auto minimal : minimals_[key]) {
+                                containing[next[minimal]++] = key;
+                            }
+                        }
+                    }
+
+                    IncidenceLattice lattice;
+                    for (size_t key = 0; key < count; ++key) {
+                        lattice.rep_.insertNode(key, std::make_tuple(std::move(values_[key]), minimals_[key]));
+                    }
+                    lattice.nextKey_ = count;
+
+                    std::vector<Key_t> supersets;
+                    std::vector<Key_t> covers;
+                    for (size_t key = 0; key < count; ++key) {
+                        const auto& minimals = minimals_[key];
+                        const auto pivot = *std::min_element(
+                                minimals.begin(),
+                                minimals.end(),
+                                [&offsets](const Key_t& a, const Key_t& b) {
+                                    return offsets[a + 1] - offsets[a] < offsets[b + 1] - offsets[b];
+                                });
+
+                        supersets.clear();
+                        for (size_t i = offsets[pivot]; i < offsets[pivot + 1]; ++i) {
+                            const auto& face = minimals_[containing[i]];
+                            if (face.size() > minimals.size() && face.includes(minimals)) {
+                                supersets.push_back(containing[i]);
+                            }
+                        }
+                        std::stable_sort(
+                                supersets.begin(),
+                                supersets.end(),
+                                [this](const Key_t& a, const Key_t& b) {
+                                    return minimals_[a].size() < minimals_[b].size();
+                                });
+
+                        // A superset is covered by a smaller one or covers
+                        // the face itself.
+                        covers.clear();
+                        for (auto& superset : supersets) {
+                            const bool isCover = std::none_of(
+                                    covers.begin(),
+                                    covers.end(),
+                                    [&superset, this](const Key_t& cover) {
+                                        return minimals_[superset].includes(minimals_[cover]);
+                                    });
+                            if (isCover) {
+                                covers.push_back(superset);
+                                lattice.rep_.insertEdge(key, superset);
+                            }
+                        }
+                    }
+
+                    faces_.clear();
+                    values_.clear();
+                    minimals_.clear();
+
+                    return lattice;
+                }
+
+            private:
+                // Faces are hashed by their minimals, which are looked up
+                // by key.
+                struct Hash {
+                    const Builder* builder;
+
+                    size_t operator()(const Key_t& key) const
+                    {
+                        size_t hash = 0;
+                        for (auto minimal : builder->minimals_[key]) {
+                            hash = (hash ^ minimal) * 0x100000001b3ull;
+                        }
+                        return hash;
+                    }
+                };
+                struct Equal {
+                    const Builder* builder;
+
+                    bool operator()(const Key_t& a, const Key_t& b) const
+                    {
+                        return builder->minimals_[a] == builder->minimals_[b];
+                    }
+                };
+
+                std::vector<Value_t> values_;
+                std::vector<Keys_t> minimals_;
+                std::unordered_set<Key_t, Hash, Equal> faces_;
+        };
+
     private:
         // Besides the Value, we save the minimal nodes to speed up face inserts.
         BidirectionalGraph<Key_t, std::tuple<Value_t, Keys_t>> rep_;
@@ -146,6 +350,48 @@ class IncidenceLattice {
             return nextKey_++;
         }
 
+        /**
+         * @brief Remove all faces which are not marked, together with their
+         * incidences.
+         */
+        void restrictTo(const std::vector<bool>& kept)
+        {
+            rep_.restrictTo([&kept](const Key_t& k) { return kept[k]; });
+        }
+
+        /**
+         * @brief Mark all faces reachable from those starts which exist and
+         * fulfill the predicate, visiting every face and edge at most once.
+         *
+         * @return Marks indexed by key.
+         */
+        template <typename Predicate, typename Next>
+        std::vector<bool> reachableFrom(const Keys_t& starts, Predicate&& isStart, Next&& next) const
+        {
+            std::vector<bool> marked(nextKey_, false);
+            std::vector<Key_t> tovisit;
+            for (auto start : starts) {
+                if (start < nextKey_ && !marked[start] && rep_.nodeExists(start) && isStart(start)) {
+                    marked[start] = true;
+                    tovisit.push_back(start);
+                }
+            }
+
+            while (!tovisit.empty()) {
+                const auto element = tovisit.back();
+                tovisit.pop_back();
+
+                for (auto item : next(element)) {
+                    if (!marked[item]) {
+                        marked[item] = true;
+                        tovisit.push_back(item);
+                    }
+                }
+            }
+
+            return marked;
+        }
+
         /**
          * @brief Search for the least Upper bounds of the given minimals.
          * A least upper bound is a node which is connected to all minimals
@@ -159,13 +405,7 @@ class IncidenceLattice {
             // A Node is an Upperbound if it is a successor of all nodes in
             // faces.
             const auto isUb = [&minimals, this](const Key_t& k) {
-                const auto& kmins = minimalsOf(k);
-                return std::all_of(
-                    minimals.begin(),
-                    minimals.end(),
-                    [&kmins](const Key_t& face) {
-                        return kmins.find(face) != kmins.end();
-                    });
+                return minimalsOf(k).includes(minimals);
             };
 
             // A Node is a least Upperbound if all of its predecessors are not
@@ -203,17 +443,11 @@ class IncidenceLattice {
             // A Node is a group if it only contains minimals who are also
             // minimals of some of the faces.
             const auto isGroup = [&minimals, this](const Key_t& k) {
-                const auto& kmins = minimalsOf(k);
-                return std::all_of(
-                    kmins.begin(),
-                    kmins.end(),
-                    [&minimals](const Key_t& min) {
-                        return minimals.find(min) != minimals.end();
-                    });
+                return minimals.includes(minimalsOf(k));
             };
 
             Keys_t groups;
-            for (auto& face : faces) {
+            for (auto face : faces) {
                 const auto faceGroups = rep_.findExtremeNodes(
                     face,
                     isGroup,
@@ -241,7 +475,7 @@ class IncidenceLattice {
             assert(!faces.empty() && "Cannot add the empty face.");
 
             Keys_t minimals;
-            for (auto& face : faces) {
+            for (auto face : faces) {
                 const auto& mins = minimalsOf(face);
                 minimals.insert(mins.begin(), mins.end());
             }
@@ -257,8 +491,8 @@ class IncidenceLattice {
 
                 if (!isEnsuredMaximal) {
                     Keys_t lubs = leastUpperBounds(minimals, *faces.begin());
-                    for (auto& lub : lubs) {
-                        for (auto& group : groups) {
+                    for (auto lub : lubs) {
+                        for (auto group : groups) {
                             rep_.deleteEdge(group, lub);
                         }
 
@@ -266,7 +500,7 @@ class IncidenceLattice {
                     }
                 }
 
-                for (auto& group : groups) {
+                for (auto group : groups) {
                     rep_.insertEdge(group, key);
                 }
 
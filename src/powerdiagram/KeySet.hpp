@@ -0,0 +1,510 @@
+#ifndef KEYSET_H
+#define KEYSET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A sorted set of integer keys, optimized for the small sets in an
+ * IncidenceLattice.
+ *
+ * Most faces have only a few predecessors, successors and minimals, which
+ * are stored inline in a sorted array. Larger sets move to a sorted vector
+ * on the heap. Once a set is at least as dense as one key per word of its
+ * key range (e.g. all minimals of a lattice, or the star of a high-degree
+ * vertex), it is stored as a bitset over that range, which takes no more
+ * memory than the vector.
+ * Iteration always yields the keys in ascending order. Subset and
+ * intersection tests work directly on the arrays or bitset words.
+ *
+ * @tparam Key_t An unsigned integer type.
+ * @tparam Inline Number of keys stored without a heap allocation.
+ */
+template <typename Key_t, size_t Inline = 4>
+class KeySet {
+    static_assert(std::is_unsigned<Key_t>::value, "Keys must be unsigned integers.");
+
+    public:
+        class const_iterator {
+            public:
+                // Bits have no address, so keys are returned by value and
+                // the iterator only models an input iterator.
+                using iterator_category = std::input_iterator_tag;
+                using value_type = Key_t;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = Key_t;
+
+                const_iterator(): set_(nullptr), position_(0), key_() { }
+
+                reference operator*() const
+                {
+                    return key_;
+                }
+                const_iterator& operator++()
+                {
+                    position_ = set_->dense_ ? set_->nextBit(position_ + 1) : position_ + 1;
+                    load();
+                    return *this;
+                }
+                const_iterator operator++(int)
+                {
+                    auto result = *this;
+                    ++(*this);
+                    return result;
+                }
+                bool operator==(const const_iterator& other) const
+                {
+                    return position_ == other.position_;
+                }
+                bool operator!=(const const_iterator& other) const
+                {
+                    return position_ != other.position_;
+                }
+
+            private:
+                friend class KeySet;
+
+                const KeySet* set_;
+                // Index into the sorted keys or bit in the bitset.
+                size_t position_;
+                // The current key.
+                Key_t key_;
+
+                const_iterator(const KeySet* set, size_t position):
+                    set_(set),
+                    position_(position),
+                    key_()
+                {
+                    load();
+                }
+
+                void load()
+                {
+                    if (position_ < set_->endPosition()) {
+                        key_ = set_->dense_ ? set_->first_ + position_ : set_->sorted()[position_];
+                    }
+                }
+        };
+        using iterator = const_iterator;
+        using value_type = Key_t;
+        using key_type = Key_t;
+        using size_type = size_t;
+
+        KeySet():
+            size_(0),
+            dense_(false),
+            first_(0),
+            inline_(),
+            heap_()
+        { }
+        KeySet(std::initializer_list<Key_t> keys): KeySet()
+        {
+            insert(keys.begin(), keys.end());
+        }
+        template <typename Iterator>
+        KeySet(Iterator first, Iterator last): KeySet()
+        {
+            insert(first, last);
+        }
+
+        const_iterator begin() const
+        {
+            return const_iterator(this, dense_ ? nextBit(0) : 0);
+        }
+        const_iterator end() const
+        {
+            return const_iterator(this, endPosition());
+        }
+        size_t size() const
+        {
+            return size_;
+        }
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+
+        bool contains(const Key_t& key) const
+        {
+            if (dense_) {
+                return hasBit(key);
+            }
+
+            const Key_t* keys = sorted();
+            if (size_ <= SmallScan) {
+                bool found = false;
+                for (size_t i = 0; i < size_; ++i) {
+                    found |= keys[i] == key;
+                }
+                return found;
+            }
+            return std::binary_search(keys, keys + size_, key);
+        }
+        size_t count(const Key_t& key) const
+        {
+            return contains(key) ? 1 : 0;
+        }
+        const_iterator find(const Key_t& key) const
+        {
+            if (!contains(key)) {
+                return end();
+            }
+            if (dense_) {
+                return const_iterator(this, key - first_);
+            }
+            return const_iterator(this, std::lower_bound(sorted(), sorted() + size_, key) - sorted());
+        }
+
+        std::pair<const_iterator, bool> insert(const Key_t& key)
+        {
+            if (dense_ && !coversDensely(key)) {
+                toSorted();
+            }
+
+            if (dense_) {
+                const bool inserted = setBit(key);
+                return std::make_pair(find(key), inserted);
+            }
+
+            Key_t* keys = sorted();
+            const size_t position = std::lower_bound(keys, keys + size_, key) - keys;
+            if (position < size_ && keys[position] == key) {
+                return std::make_pair(const_iterator(this, position), false);
+            }
+
+            if (size_ < Inline) {
+                std::copy_backward(inline_ + position, inline_ + size_, inline_ + size_ + 1);
+                inline_[position] = key;
+            } else {
+                if (size_ == Inline) {
+                    heap_.assign(inline_, inline_ + Inline);
+                }
+                heap_.insert(heap_.begin() + position, key);
+            }
+            ++size_;
+
+            compact();
+            return std::make_pair(dense_ ? find(key) : const_iterator(this, position), true);
+        }
+        /**
+         * @brief Insert with a hint, as used by std::inserter. The hint is
+         * ignored.
+         */
+        const_iterator insert(const_iterator, const Key_t& key)
+        {
+            return insert(key).first;
+        }
+        template <typename Iterator>
+        void insert(Iterator first, Iterator last)
+        {
+            if (!empty()) {
+                for (; first != last; ++first) {
+                    insert(*first);
+                }
+                return;
+            }
+
+            // Build empty sets in one go.
+            std::vector<Key_t> keys(first, last);
+            std::sort(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+            assign(std::move(keys));
+            compact();
+        }
+
+        size_t erase(const Key_t& key)
+        {
+            if (dense_) {
+                if (!clearBit(key)) {
+                    return 0;
+                }
+                // Do not keep sparse bitsets around.
+                if (size_ < DenseMinimum / 2 || heap_.size() > 2 * size_) {
+                    toSorted();
+                }
+                return 1;
+            }
+
+            Key_t* keys = sorted();
+            const size_t position = std::lower_bound(keys, keys + size_, key) - keys;
+            if (position == size_ || keys[position] != key) {
+                return 0;
+            }
+
+            if (size_ <= Inline) {
+                std::copy(inline_ + position + 1, inline_ + size_, inline_ + position);
+            } else {
+                heap_.erase(heap_.begin() + position);
+                if (size_ == Inline + 1) {
+                    std::copy(heap_.begin(), heap_.end(), inline_);
+                    std::vector<Key_t>().swap(heap_);
+                }
+            }
+            --size_;
+
+            return 1;
+        }
+        void clear()
+        {
+            size_ = 0;
+            dense_ = false;
+            std::vector<Key_t>().swap(heap_);
+        }
+
+        /**
+         * @brief Whether all keys of other are in this set.
+         */
+        bool includes(const KeySet& other) const
+        {
+            if (other.size_ > size_) {
+                return false;
+            }
+
+            if (dense_ && other.dense_) {
+                // Words of other outside of this range must be empty.
+                for (size_t i = 0; i < other.heap_.size(); ++i) {
+                    const Key_t word = other.heap_[i];
+                    const Key_t mine = wordAt(other.first_ + i * Bits);
+                    if ((word & ~mine) != 0) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            if (!dense_ && !other.dense_ && size_ > SmallScan) {
+                return std::includes(sorted(), sorted() + size_, other.sorted(), other.sorted() + other.size_);
+            }
+
+            for (auto key : other) {
+                if (!contains(key)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Whether this set and other have a key in common.
+         */
+        bool intersects(const KeySet& other) const
+        {
+            if (dense_ && other.dense_) {
+                Key_t common = 0;
+                for (size_t i = 0; i < other.heap_.size(); ++i) {
+                    common |= other.heap_[i] & wordAt(other.first_ + i * Bits);
+                }
+                return common != 0;
+            }
+            if (other.dense_ || (!dense_ && other.size_ > size_)) {
+                return other.intersects(*this);
+            }
+            if (!dense_ && size_ > SmallScan) {
+                // Both are sorted, walk them in lockstep.
+                const Key_t* a = sorted();
+                const Key_t* aEnd = a + size_;
+                const Key_t* b = other.sorted();
+                const Key_t* bEnd = b + other.size_;
+                while (a != aEnd && b != bEnd) {
+                    if (*a < *b) {
+                        ++a;
+                    } else if (*b < *a) {
+                        ++b;
+                    } else {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            for (auto key : other) {
+                if (contains(key)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool operator==(const KeySet& other) const
+        {
+            return size_ == other.size_ && includes(other);
+        }
+        bool operator!=(const KeySet& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        static constexpr size_t Bits = 8 * sizeof(Key_t);
+        // Up to this size, linear scans beat binary searches.
+        static constexpr size_t SmallScan = 8;
+        // Smaller sets are never stored as bitsets.
+        static constexpr size_t DenseMinimum = 64;
+
+        size_t size_;
+        bool dense_;
+        // The key of the first bit, a multiple of Bits.
+        Key_t first_;
+        Key_t inline_[Inline];
+        // The sorted keys of large sets, or the words of the bitset.
+        std::vector<Key_t> heap_;
+
+        const Key_t* sorted() const
+        {
+            return size_ <= Inline ? inline_ : heap_.data();
+        }
+        Key_t* sorted()
+        {
+            return size_ <= Inline ? inline_ : heap_.data();
+        }
+        size_t endPosition() const
+        {
+            return dense_ ? heap_.size() * Bits : size_;
+        }
+
+        static size_t wordsSpanned(const Key_t& first, const Key_t& last)
+        {
+            return last / Bits - first / Bits + 1;
+        }
+
+        static size_t lowestBit(Key_t word)
+        {
+            return __builtin_ctzll(static_cast<unsigned long long>(word));
+        }
+        static size_t bitCount(Key_t word)
+        {
+            return __builtin_popcountll(static_cast<unsigned long long>(word));
+        }
+
+        /**
+         * @brief The first set bit at or after position, or endPosition().
+         */
+        size_t nextBit(size_t position) const
+        {
+            size_t word = position / Bits;
+            if (word >= heap_.size()) {
+                return endPosition();
+            }
+
+            Key_t bits = heap_[word] & (~Key_t(0) << (position % Bits));
+            while (bits == 0) {
+                if (++word == heap_.size()) {
+                    return endPosition();
+                }
+                bits = heap_[word];
+            }
+            return word * Bits + lowestBit(bits);
+        }
+
+        /**
+         * @brief The bitset word containing key, which is 0 outside of the
+         * range of the bitset.
+         */
+        Key_t wordAt(const Key_t& key) const
+        {
+            if (key < first_ || (key - first_) / Bits >= heap_.size()) {
+                return 0;
+            }
+            return heap_[(key - first_) / Bits];
+        }
+        bool hasBit(const Key_t& key) const
+        {
+            return (wordAt(key) >> ((key - first_) % Bits)) & 1;
+        }
+
+        /**
+         * @brief Whether key can be added to the bitset without making it
+         * sparser than one key per word.
+         */
+        bool coversDensely(const Key_t& key) const
+        {
+            const Key_t last = first_ + heap_.size() * Bits - 1;
+            return wordsSpanned(std::min(key, first_), std::max(key, last)) <= size_ + 1;
+        }
+        bool setBit(const Key_t& key)
+        {
+            if (key < first_) {
+                const size_t words = first_ / Bits - key / Bits;
+                heap_.insert(heap_.begin(), words, Key_t(0));
+                first_ -= words * Bits;
+            }
+            if ((key - first_) / Bits >= heap_.size()) {
+                heap_.resize((key - first_) / Bits + 1, Key_t(0));
+            }
+
+            Key_t& word = heap_[(key - first_) / Bits];
+            const Key_t bit = Key_t(1) << ((key - first_) % Bits);
+            if (word & bit) {
+                return false;
+            }
+            word |= bit;
+            ++size_;
+            return true;
+        }
+        bool clearBit(const Key_t& key)
+        {
+            if (!hasBit(key)) {
+                return false;
+            }
+            heap_[(key - first_) / Bits] &= ~(Key_t(1) << ((key - first_) % Bits));
+            --size_;
+            return true;
+        }
+
+        void assign(std::vector<Key_t>&& keys)
+        {
+            dense_ = false;
+            size_ = keys.size();
+            if (size_ <= Inline) {
+                std::copy(keys.begin(), keys.end(), inline_);
+                std::vector<Key_t>().swap(heap_);
+            } else {
+                heap_ = std::move(keys);
+            }
+        }
+        /**
+         * @brief Switch a sorted set to a bitset if that is small enough.
+         */
+        void compact()
+        {
+            if (!dense_ && size_ >= DenseMinimum && wordsSpanned(sorted()[0], sorted()[size_ - 1]) <= size_) {
+                toDense();
+            }
+        }
+        void toDense()
+        {
+            const Key_t first = sorted()[0] / Bits * Bits;
+            std::vector<Key_t> words(wordsSpanned(first, sorted()[size_ - 1]), Key_t(0));
+            for (size_t i = 0; i < size_; ++i) {
+                const Key_t key = sorted()[i] - first;
+                words[key / Bits] |= Key_t(1) << (key % Bits);
+            }
+
+            heap_.swap(words);
+            first_ = first;
+            dense_ = true;
+        }
+        void toSorted()
+        {
+            std::vector<Key_t> keys;
+            keys.reserve(size_);
+            for (auto key : *this) {
+                keys.push_back(key);
+            }
+            assign(std::move(keys));
+        }
+};
+
+template <typename Key_t, size_t Inline>
+constexpr size_t KeySet<Key_t, Inline>::Bits;
+template <typename Key_t, size_t Inline>
+constexpr size_t KeySet<Key_t, Inline>::SmallScan;
+template <typename Key_t, size_t Inline>
+constexpr size_t KeySet<Key_t, Inline>::DenseMinimum;
+
+#endif
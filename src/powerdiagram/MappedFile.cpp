@@ -0,0 +1,85 @@
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static std::runtime_error fileError(const char* path, const char* what)
+{
+    return std::runtime_error(
+            std::string(path) + ": " + what + " (" + std::strerror(errno) + ")");
+}
+
+#ifdef HAVE_MMAP
+MappedFile::MappedFile(const char* path):
+    data_(nullptr),
+    size_(0),
+    buffer_()
+{
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        throw fileError(path, "Cannot open file");
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw fileError(path, "Cannot stat file");
+    }
+    size_ = info.st_size;
+
+    // Mapping an empty file is an error, an empty view is not.
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw fileError(path, "Cannot map file");
+        }
+
+        // The files are always parsed front to back.
+        madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(data);
+    }
+
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+#else
+MappedFile::MappedFile(const char* path):
+    data_(nullptr),
+    size_(0),
+    buffer_()
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        throw fileError(path, "Cannot open file");
+    }
+
+    buffer_.assign(
+            std::istreambuf_iterator<char>(stream),
+            std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile()
+{
+}
+#endif
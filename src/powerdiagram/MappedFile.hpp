@@ -0,0 +1,37 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief A read-only view of the complete contents of a file.
+ *
+ * On POSIX systems the file is memory-mapped, so the contents are only paged
+ * in once they are actually read. Elsewhere the file is read into a buffer.
+ * The contents are not null-terminated.
+ */
+class MappedFile {
+    public:
+        /**
+         * @brief Map the file with the given name.
+         * Throws std::runtime_error if the file cannot be opened or mapped.
+         */
+        explicit MappedFile(const char* path);
+        virtual ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* begin() const { return data_; }
+        const char* end() const { return data_ + size_; }
+        size_t size() const { return size_; }
+
+    private:
+        const char* data_;
+        size_t size_;
+        // Only used if the file could not be mapped.
+        std::vector<char> buffer_;
+};
+
+#endif
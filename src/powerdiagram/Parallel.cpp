@@ -0,0 +1,14 @@
+#include "Parallel.hpp"
+
+#include <gflags/gflags.h>
+
+DEFINE_int32(threads, 0, "Number of threads for parallel steps (0: one per core)");
+
+size_t Parallel::threads()
+{
+    if (FLAGS_threads > 0) {
+        return FLAGS_threads;
+    }
+
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
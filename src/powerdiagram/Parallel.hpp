@@ -0,0 +1,91 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Minimal helpers to spread independent loop iterations over threads.
+ */
+class Parallel {
+    public:
+        virtual ~Parallel() { }
+
+        /**
+         * @brief The number of worker threads to use (see --threads).
+         */
+        static size_t threads();
+
+        /**
+         * @brief Call function(i) for all i in [0, count) on up to threads()
+         * threads. Indices are handed out dynamically in blocks of grain
+         * consecutive indices, so the order of the calls is unspecified.
+         * If any calls throw, the exception of the lowest such i is rethrown
+         * once all threads have finished, the same one a serial loop would
+         * throw. Indices are handed out in increasing order, so every index
+         * below a failing one has been run when the threads stop.
+         */
+        template <typename Function>
+        static void forEach(size_t count, Function&& function, size_t grain = 1)
+        {
+            grain = std::max<size_t>(grain, 1);
+            const size_t workers = std::min(threads(), (count + grain - 1) / grain);
+
+            if (workers <= 1) {
+                for (size_t i = 0; i < count; ++i) {
+                    function(i);
+                }
+                return;
+            }
+
+            std::atomic<size_t> next(0);
+            std::exception_ptr error;
+            size_t errorIndex = count;
+            std::mutex errorMutex;
+
+            const auto work = [&]() {
+                size_t i = 0;
+                try {
+                    for (size_t begin = next.fetch_add(grain);
+                            begin < count;
+                            begin = next.fetch_add(grain)) {
+                        const size_t end = std::min(begin + grain, count);
+                        for (i = begin; i < end; ++i) {
+                            function(i);
+                        }
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (i < errorIndex) {
+                        error = std::current_exception();
+                        errorIndex = i;
+                    }
+                    // Let the other threads run out of work.
+                    next = count;
+                }
+            };
+
+            std::vector<std::thread> pool;
+            for (size_t i = 1; i < workers; ++i) {
+                pool.emplace_back(work);
+            }
+            work();
+            for (auto& thread : pool) {
+                thread.join();
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+    private:
+        Parallel();
+};
+
+#endif
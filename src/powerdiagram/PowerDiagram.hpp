@@ -11,6 +11,19 @@
 class PowerDiagram {
     public:
         using Sphere_t = std::tuple<Eigen::VectorXd, double>;
+        /**
+         * @brief Spheres given as one matrix whose columns are the centers
+         * and a vector of radii, like the ones read by FromCSV::read. Both
+         * may refer to memory the diagram does not own.
+         */
+        using Centers_t = Eigen::Ref<const Eigen::MatrixXd>;
+        using Radii_t = Eigen::Ref<const Eigen::VectorXd>;
+        /**
+         * @brief A sphere whose dimension is fixed at compile time, or
+         * Eigen::Dynamic.
+         */
+        template <int Dimension>
+        using FixedSphere_t = std::tuple<Eigen::Matrix<double, Dimension, 1>, double>;
 
         virtual ~PowerDiagram() { }
 
@@ -18,17 +31,28 @@ class PowerDiagram {
         {
             return std::make_tuple(center, radius);
         }
-        static double power(const Sphere_t& sphere, const Eigen::VectorXd& point)
+        template <typename Center, typename Point>
+        static double power(const std::tuple<Center, double>& sphere, const Eigen::MatrixBase<Point>& point)
         {
-            Eigen::VectorXd center;
-            double radius;
-            std::tie(center, radius) = sphere;
+            const auto& center = std::get<0>(sphere);
+            const double radius = std::get<1>(sphere);
 
-            const auto diff = center - point;
-            return diff.dot(diff) - radius * radius;
+            return (center - point).squaredNorm() - radius * radius;
         }
 
-        virtual IncidenceLattice<Eigen::VectorXd> fromSpheres(const std::vector<Sphere_t>& spheres) = 0;
+        virtual IncidenceLattice<Eigen::VectorXd> fromSpheres(const Centers_t& centers, const Radii_t& radii) = 0;
+        virtual IncidenceLattice<Eigen::VectorXd> fromSpheres(const std::vector<Sphere_t>& spheres)
+        {
+            const size_t dimension = spheres.empty() ? 0 : std::get<0>(spheres[0]).size();
+            Eigen::MatrixXd centers(dimension, spheres.size());
+            Eigen::VectorXd radii(spheres.size());
+            for (size_t i = 0; i < spheres.size(); ++i) {
+                centers.col(i) = std::get<0>(spheres[i]);
+                radii[i] = std::get<1>(spheres[i]);
+            }
+
+            return fromSpheres(centers, radii);
+        }
 
     protected:
         PowerDiagram() { }
@@ -1,75 +1,81 @@
 #include "PowerDiagramDual.hpp"
 
+#include "FixedDimension.hpp"
+#include "Parallel.hpp"
+
 #include <gflags/gflags.h>
 #include <iostream>
 #include <iterator>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 DECLARE_bool(verbose);
 
 using Eigen::MatrixXd;
 using Eigen::VectorXd;
+using Lattice_t = IncidenceLattice<VectorXd>;
+using Keys_t = Lattice_t::Keys_t;
+using Key_t = Lattice_t::Key_t;
 
-static VectorXd normalToAffineSpace(const std::vector<VectorXd>& vectors)
+/**
+ * @brief Calculate a normal to the affine hull of the first cols
+ * coordinates of the values of the given nodes.
+ *
+ * @tparam Rows Number of nodes minus one, if known at compile time.
+ * @tparam Cols Number of coordinates, if known at compile time.
+ */
+template <int Rows, int Cols>
+static Eigen::Matrix<double, Cols, 1> normalToAffineSpace(
+        const Lattice_t& lattice,
+        const Keys_t& nodes,
+        int cols)
 {
-    MatrixXd A(vectors.size() - 1, vectors[0].size());
-    for (size_t i = 1; i < vectors.size(); ++i) {
-        A.row(i - 1) = vectors[i] - vectors[0];
+    Eigen::Matrix<double, Rows, Cols> A;
+    A.resize(nodes.size() - 1, cols);
+
+    auto it = nodes.begin();
+    const auto first = lattice.value(*it).head(cols);
+    ++it;
+    for (int i = 0; it != nodes.end(); ++it, ++i) {
+        A.row(i) = (lattice.value(*it).head(cols) - first).transpose();
     }
 
-    return A.fullPivLu().kernel().col(0).normalized();
+    return FixedDimension::kernelOf(A).normalized();
 }
 
 /**
  * @brief Calculate a normal which, in relation to the convex hull of the
  * vertices, faces outwards.
- * Since we assume the polytope to be fully dimensional, there has
- * to exist some point not in the facet. The dot product of the
- * normal and this point has to be smaller than zero if the normal
- * points outwards.
+ * Since we assume the polytope to be fully dimensional, a point in its
+ * interior, like the centroid of all vertices, lies strictly below every
+ * facet.
  *
  * @param normal Normal vector of some facet which might point inwards.
  * @param vertexOnFacet A vertex guaranteed to be on the facet.
- * @param vertices All vertices.
+ * @param interior A point in the interior of the hull.
  *
  * @return Either normal or (-1) * normal, whichever points outwards.
  */
-static VectorXd outwardsNormal(
-        const VectorXd& normal,
+template <typename Normal>
+static Normal outwardsNormal(
+        const Normal& normal,
         const VectorXd& vertexOnFacet,
-        const std::vector<VectorXd>& vertices)
+        const VectorXd& interior)
 {
-    // FIXME: This might cause numerical issues.
-    const double epsilon = 1e-3;
-    for (auto& vertex : vertices) {
-        const auto dot = normal.dot(vertex - vertexOnFacet);
-        if (dot > epsilon) {
-            return (-1) * normal;
-        } else if (dot < -epsilon) {
-            return normal;
-        }
+    if (normal.dot(interior - vertexOnFacet) > 0) {
+        return (-1) * normal;
     }
 
-    // This should only happen if the hull is not fully dimensional.
     return normal;
 }
 
-static VectorXd polarOfSphere(const PowerDiagram::Sphere_t& sphere)
-{
-    VectorXd center;
-    double radius;
-    std::tie(center, radius) = sphere;
-
-    VectorXd res(center.size() + 1);
-    res << center, center.dot(center) - radius * radius;
-    return res;
-}
-
-static VectorXd polarOfHyperplane(const VectorXd& normal, double offset)
+template <typename Normal>
+static Normal polarOfHyperplane(const Normal& normal, double offset)
 {
     const auto last = normal.size() - 1;
 
-    VectorXd res = normal;
+    Normal res = normal;
     res *= 0.5;
     res[last] = -offset;
     res *= -1.0 / normal[last];
@@ -77,159 +83,249 @@ static VectorXd polarOfHyperplane(const VectorXd& normal, double offset)
     return res;
 }
 
-IncidenceLattice<VectorXd> PowerDiagramDual::fromSpheres(const std::vector<Sphere_t>& spheres)
+/**
+ * @brief Power of a point with respect to a sphere stored in the lattice,
+ * i.e. a center with the radius appended.
+ */
+template <typename Point>
+static double latticePower(const VectorXd& sphere, const Eigen::MatrixBase<Point>& point)
 {
-    const auto dimension = std::get<0>(spheres[0]).size();
-
-    // Find polars
-    std::vector<VectorXd> polars(spheres.size());
-    std::transform(spheres.begin(), spheres.end(), polars.begin(), [](Sphere_t sphere) {
-            return polarOfSphere(sphere);
-        });
+    const auto dimension = point.size();
+    const double radius = sphere[dimension];
 
-    if (FLAGS_verbose) {
-        for (auto& polar : polars) {
-            std::cerr << "Polar: " << polar.transpose() << std::endl;
-        }
-    }
+    return (sphere.head(dimension) - point).squaredNorm() - radius * radius;
+}
 
-    // Calculate their convex hull
-    IncidenceLattice<VectorXd> dualIncidences = hull_.hullOf(polars);
-    using Keys_t = IncidenceLattice<VectorXd>::Keys_t;
-    using Key_t = IncidenceLattice<VectorXd>::Key_t;
-
-    // Calculate normals of the hyperplanes (facets),
-    // Restrict the incidence lattice to the facets on the bottom side
-    Keys_t bottoms;
-    for (auto& facet : dualIncidences.maximals()) {
-        std::vector<VectorXd> facetPoints;
-        for (auto& key : dualIncidences.minimalsOf(facet)) {
-            facetPoints.push_back(dualIncidences.value(key));
+/**
+ * @brief The dual algorithm for spheres of a fixed dimension (or
+ * Eigen::Dynamic).
+ * The lifted polars and normals have one dimension more, the directions of
+ * edges have as many dimensions as the spheres. Faces with the minimal number
+ * of vertices (simplices) are handled with fixed-size matrices.
+ */
+template <int Dimension>
+struct DualEngine {
+    enum {
+        Lifted = FixedDimension::Lifted<Dimension>::value,
+        Reduced = FixedDimension::Reduced<Dimension>::value
+    };
+    using Point_t = Eigen::Matrix<double, Dimension, 1>;
+    using Polar_t = Eigen::Matrix<double, Lifted, 1>;
+
+    /**
+     * @brief The outward normal of a facet of the lifted hull, either the one
+     * stored by the hull algorithm or a new one.
+     */
+    static Polar_t facetNormal(
+            const Lattice_t& lattice,
+            const Key_t& facet,
+            size_t dimension,
+            const VectorXd& centroid)
+    {
+        if (static_cast<size_t>(lattice.value(facet).size()) == dimension + 1) {
+            return lattice.value(facet);
         }
 
         // Find any normal
-        auto normal = normalToAffineSpace(facetPoints);
+        const auto& facetVertices = lattice.minimalsOf(facet);
+        Polar_t normal;
+        if (facetVertices.size() == dimension + 1) {
+            normal = normalToAffineSpace<Dimension, Lifted>(lattice, facetVertices, dimension + 1);
+        } else {
+            normal = normalToAffineSpace<Eigen::Dynamic, Lifted>(lattice, facetVertices, dimension + 1);
+        }
 
         // Make sure the normal points outwards
-        normal = outwardsNormal(normal, facetPoints[0], polars);
+        return outwardsNormal(normal, lattice.value(*facetVertices.begin()), centroid);
+    }
 
-        if (FLAGS_verbose) {
-          std::cerr << "Normal: " << normal.transpose();
+    /**
+     * @brief The direction of an edge of the diagram. If the edge is an
+     * extremal one, we find the "correct" direction starting from the
+     * existing 0-face point.
+     */
+    static Point_t edgeDirection(
+            const Lattice_t& lattice,
+            const Key_t& edge,
+            const Key_t& point,
+            size_t dimension)
+    {
+        const auto& minimalsOfEdge = lattice.minimalsOf(edge);
+
+        Point_t direction;
+        if (minimalsOfEdge.size() == dimension) {
+            direction = normalToAffineSpace<Reduced, Dimension>(lattice, minimalsOfEdge, dimension);
+        } else {
+            direction = normalToAffineSpace<Eigen::Dynamic, Dimension>(lattice, minimalsOfEdge, dimension);
         }
 
-        // Save normal in incidence lattice
-        dualIncidences.value(facet) = normal;
-
-        if (normal[dimension] < 0) {
-            bottoms.insert(facet);
-            if (FLAGS_verbose) {
-              std::cerr << " Is bottom!";
+        if (lattice.successors(edge).size() == 1) {
+            // This is an extremal edge, so we care about the sign
+            // of the direction.
+            // We find the direction by comparing the power on the
+            // edge to the power of the additional sphere which
+            // defines the point "point" the edge is also adjacent
+            // to. The correct direction is then the one facing
+            // "away" (in terms of power) from this sphere.
+
+            const auto& minimalsOfPoint = lattice.minimalsOf(point);
+            Keys_t candidates;
+            std::set_difference(
+                    minimalsOfPoint.begin(),
+                    minimalsOfPoint.end(),
+                    minimalsOfEdge.begin(),
+                    minimalsOfEdge.end(),
+                    std::inserter(candidates, candidates.begin())
+                    );
+
+            const Point_t testPoint = lattice.value(point) + direction;
+
+            const auto activePower = latticePower(
+                    lattice.value(*minimalsOfEdge.begin()),
+                    testPoint);
+            const auto inactivePower = latticePower(
+                    lattice.value(*candidates.begin()),
+                    testPoint);
+
+            if (activePower > inactivePower) {
+                direction *= (-1);
             }
         }
-        if (FLAGS_verbose) {
-          std::cerr << std::endl;
-        }
+
+        return direction;
     }
-    dualIncidences.restrictToMaximals(bottoms);
 
-    // Calculate the dual (i.e. project the hyperplanes),
-    // project the dual points onto H0 (i.e. forget last coordinate)
-    for (auto& facet : dualIncidences.maximals()) {
-        const auto normal = dualIncidences.value(facet);
-        const auto vertex = *dualIncidences.minimalsOf(facet).begin();
-        const double offset = normal.dot(dualIncidences.value(vertex));
+    static IncidenceLattice<VectorXd> run(
+            const PowerDiagram::Centers_t& centers,
+            const PowerDiagram::Radii_t& radii,
+            ConvexHullAlgorithm& hull,
+            MatrixXd& polars)
+    {
+        const size_t dimension = centers.rows();
 
-        const auto polar = polarOfHyperplane(normal, offset);
-        dualIncidences.value(facet) = polar.head(dimension);
+        // Find polars, directly in the layout the hull algorithm takes
+        polars.resize(dimension + 1, centers.cols());
+        polars.topRows(dimension) = centers;
+        polars.row(dimension) = centers.colwise().squaredNorm() - radii.cwiseAbs2().transpose();
 
         if (FLAGS_verbose) {
-            std::cerr << "0-Face at: " << polar.head(dimension).transpose() << std::endl;
+            for (Eigen::Index i = 0; i < polars.cols(); ++i) {
+                std::cerr << "Polar: " << polars.col(i).transpose() << std::endl;
+            }
         }
-    }
 
-    // Project Sphere centers back to the original space from the polar points.
-    // FIXME(mrksr): We recover the radii a bit clumsily here by comparing vectors.
-    for (auto& sphere : dualIncidences.minimals()) {
-        auto& polar = dualIncidences.value(sphere);
+        // Calculate the lower part of their convex hull, remembering which
+        // sphere every vertex belongs to.
+        ConvexHullAlgorithm::Indices_t sphereOf;
+        IncidenceLattice<VectorXd> dualIncidences = hull.hullOf(
+                polars,
+                sphereOf,
+                ConvexHullAlgorithm::Part::Lower);
+
+        // Calculate normals of the hyperplanes (facets), unless the hull
+        // already did. Restrict the incidence lattice to the facets on the
+        // bottom side.
+        const VectorXd centroid = polars.rowwise().mean();
+
+        // All stages below work on a snapshot of the keys on all threads and
+        // write their results back afterwards, the lattice is only read in
+        // between.
+        const auto facetKeys = dualIncidences.maximals();
+        const std::vector<Key_t> facets(facetKeys.begin(), facetKeys.end());
+        std::vector<Polar_t, Eigen::aligned_allocator<Polar_t>> normals(facets.size());
+        Parallel::forEach(facets.size(), [&](size_t i) {
+                normals[i] = facetNormal(dualIncidences, facets[i], dimension, centroid);
+            }, 64);
+
+        Keys_t bottoms;
+        for (size_t i = 0; i < facets.size(); ++i) {
+            const auto& normal = normals[i];
+            if (FLAGS_verbose) {
+              std::cerr << "Normal: " << normal.transpose();
+            }
 
-        const auto it = std::find(polars.begin(), polars.end(), polar);
-        assert(it != polars.end() && "Clumsy radius recovery failed.");
-        const auto idx = std::distance(polars.begin(), it);
+            // Save normal in incidence lattice
+            dualIncidences.value(facets[i]) = normal;
 
-        // To make it possible to recover the radius, we add it as the (d+1)st
-        // value into the sphere.
-        polar[dimension] = std::get<1>(spheres.at(idx));
-    }
+            if (normal[dimension] < 0) {
+                bottoms.insert(facets[i]);
+                if (FLAGS_verbose) {
+                  std::cerr << " Is bottom!";
+                }
+            }
+            if (FLAGS_verbose) {
+              std::cerr << std::endl;
+            }
+        }
+        // The hull should only contain bottom facets already, but it might
+        // decide differently about (almost) vertical ones.
+        if (bottoms.size() != facets.size()) {
+            dualIncidences.restrictToMaximals(bottoms);
+        }
 
-    // Find directions of all the edges. If the edge is an extremal one, we
-    // find the "correct" direction starting from the existing 0-face.
-    // We call the maximals "point" here since we have dualized them before
-    if (dimension > 1) {
-        std::unordered_set<Key_t> visitedEdges;
+        // Calculate the dual (i.e. project the hyperplanes),
+        // project the dual points onto H0 (i.e. forget last coordinate)
+        const std::vector<Key_t> points(bottoms.begin(), bottoms.end());
+        std::vector<Point_t, Eigen::aligned_allocator<Point_t>> positions(points.size());
+        Parallel::forEach(points.size(), [&](size_t i) {
+                const Polar_t normal = dualIncidences.value(points[i]);
+                const auto vertex = *dualIncidences.minimalsOf(points[i]).begin();
+                const double offset = normal.dot(dualIncidences.value(vertex));
 
-        for (auto& point : dualIncidences.maximals()) {
-            for (auto& edge : dualIncidences.predecessors(point)) {
-                // If an "edge" is minimal, there is an edge missing.
-                assert(!dualIncidences.isMinimal(edge) && "There is probably an edge missing.");
+                positions[i] = polarOfHyperplane(normal, offset).head(dimension);
+            }, 64);
 
-                if (visitedEdges.find(edge) == visitedEdges.end()) {
-                    visitedEdges.insert(edge);
+        for (size_t i = 0; i < points.size(); ++i) {
+            dualIncidences.value(points[i]) = positions[i];
 
-                    std::vector<VectorXd> spheres;
-                    for (auto& sphere : dualIncidences.minimalsOf(edge)) {
-                        spheres.push_back(dualIncidences.value(sphere).head(dimension));
-                    }
+            if (FLAGS_verbose) {
+                std::cerr << "0-Face at: " << positions[i].transpose() << std::endl;
+            }
+        }
 
-                    auto direction = normalToAffineSpace(spheres);
-
-                    if (dualIncidences.successors(edge).size() == 1) {
-                        // This is an extremal edge, so we care about the sign
-                        // of the direction.
-                        // We find the direction by comparing the power on the
-                        // edge to the power of the additional sphere which
-                        // defines the point "point" the edge is also adjacent
-                        // to. The correct direction is then the one facing
-                        // "away" (in terms of power) from this sphere.
-
-                        const auto& minimalsOfPoint = dualIncidences.minimalsOf(point);
-                        const auto& minimalsOfEdge = dualIncidences.minimalsOf(edge);
-                        Keys_t candidates;
-                        std::set_difference(
-                                minimalsOfPoint.begin(),
-                                minimalsOfPoint.end(),
-                                minimalsOfEdge.begin(),
-                                minimalsOfEdge.end(),
-                                std::inserter(candidates, candidates.begin())
-                                );
-
-                        const auto testPoint = dualIncidences.value(point) + direction;
-
-                        const auto& activeSphere = dualIncidences.value(*minimalsOfEdge.begin());
-                        const auto activePower = PowerDiagram::power(
-                                PowerDiagram::sphere(
-                                    activeSphere.head(dimension),
-                                    activeSphere[dimension]
-                                    ),
-                                testPoint);
-
-                        const auto& inactiveSphere = dualIncidences.value(*candidates.begin());
-                        const auto inactivePower = PowerDiagram::power(
-                                PowerDiagram::sphere(
-                                    inactiveSphere.head(dimension),
-                                    inactiveSphere[dimension]
-                                    ),
-                                testPoint);
-
-                        if (activePower > inactivePower) {
-                            direction *= (-1);
-                        }
-                    }
+        // Project Sphere centers back to the original space from the polar points.
+        for (auto sphere : dualIncidences.minimals()) {
+            auto& polar = dualIncidences.value(sphere);
+
+            // To make it possible to recover the radius, we add it as the (d+1)st
+            // value into the sphere.
+            polar[dimension] = radii[sphereOf.at(sphere)];
+        }
 
-                    dualIncidences.value(edge) = direction;
+        // Find directions of all the edges, together with the first point
+        // (0-face) we reach them from.
+        // We call the maximals "point" here since we have dualized them before
+        if (dimension > 1) {
+            std::unordered_set<Key_t> visitedEdges;
+            std::vector<std::pair<Key_t, Key_t>> edges;
+
+            for (auto& point : points) {
+                for (auto edge : dualIncidences.predecessors(point)) {
+                    // If an "edge" is minimal, there is an edge missing.
+                    assert(!dualIncidences.isMinimal(edge) && "There is probably an edge missing.");
+
+                    if (visitedEdges.find(edge) == visitedEdges.end()) {
+                        visitedEdges.insert(edge);
+                        edges.push_back(std::make_pair(edge, point));
+                    }
                 }
             }
+
+            std::vector<Point_t, Eigen::aligned_allocator<Point_t>> directions(edges.size());
+            Parallel::forEach(edges.size(), [&](size_t i) {
+                    directions[i] = edgeDirection(dualIncidences, edges[i].first, edges[i].second, dimension);
+                }, 64);
+
+            for (size_t i = 0; i < edges.size(); ++i) {
+                dualIncidences.value(edges[i].first) = directions[i];
+            }
         }
+
+        return dualIncidences;
     }
+};
 
-    return dualIncidences;
+IncidenceLattice<VectorXd> PowerDiagramDual::fromSpheres(const Centers_t& centers, const Radii_t& radii)
+{
+    return FixedDimension::dispatch<DualEngine>(centers.rows(), centers, radii, hull_, polars_);
 }
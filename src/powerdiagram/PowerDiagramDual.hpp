@@ -11,13 +11,16 @@
 
 class PowerDiagramDual : public PowerDiagram {
     public:
-        PowerDiagramDual(ConvexHullAlgorithm& hull) : hull_(hull) { }
+        PowerDiagramDual(ConvexHullAlgorithm& hull) : hull_(hull), polars_() { }
         virtual ~PowerDiagramDual() { }
 
-        virtual IncidenceLattice<Eigen::VectorXd> fromSpheres(const std::vector<PowerDiagram::Sphere_t>& spheres);
+        using PowerDiagram::fromSpheres;
+        virtual IncidenceLattice<Eigen::VectorXd> fromSpheres(const Centers_t& centers, const Radii_t& radii);
 
     private:
         ConvexHullAlgorithm& hull_;
+        // The lifted spheres, kept to reuse the memory for the next diagram.
+        Eigen::MatrixXd polars_;
 };
 
 #endif
@@ -0,0 +1,755 @@
+#include "PowerDiagramDynamic.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using Id_t = PowerDiagramDynamic::Id_t;
+
+// The vertex at infinity. Also marks neighbors which are not linked yet.
+static const size_t infinite = std::numeric_limits<size_t>::max();
+
+//FIXME: These tolerances might cause numerical issues.
+static const double powerTolerance = 1e-10;
+static const double orientationTolerance = 1e-10;
+static const double barycentricTolerance = 1e-12;
+
+/**
+ * @brief The vertices without the one at position skip, sorted, to identify
+ * a facet independently of the simplex it belongs to.
+ */
+static std::vector<Id_t> facetKey(const std::vector<Id_t>& vertices, size_t skip)
+{
+    std::vector<Id_t> facet;
+    facet.reserve(vertices.size() - 1);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        if (i != skip) {
+            facet.push_back(vertices[i]);
+        }
+    }
+    std::sort(facet.begin(), facet.end());
+
+    return facet;
+}
+
+PowerDiagramDynamic::PowerDiagramDynamic():
+    PowerDiagramDynamic(true)
+{ }
+
+PowerDiagramDynamic::PowerDiagramDynamic(bool maintainLattice):
+    maintainLattice_(maintainLattice),
+    dimension_(0),
+    size_(0),
+    centers_(),
+    radii_(),
+    states_(),
+    simplexOf_(),
+    keys_(),
+    pending_(),
+    simplices_(),
+    free_(),
+    hint_(0),
+    epoch_(0),
+    random_(),
+    lattice_()
+{ }
+
+IncidenceLattice<VectorXd> PowerDiagramDynamic::fromSpheres(const Centers_t& centers, const Radii_t& radii)
+{
+    clear();
+    for (Eigen::Index i = 0; i < radii.size(); ++i) {
+        place(addSphere(centers.col(i), radii[i]));
+    }
+
+    return lattice_;
+}
+
+void PowerDiagramDynamic::clear()
+{
+    dimension_ = 0;
+    size_ = 0;
+    centers_.clear();
+    radii_.clear();
+    states_.clear();
+    simplexOf_.clear();
+    keys_.clear();
+    pending_.clear();
+    simplices_.clear();
+    free_.clear();
+    hint_ = 0;
+    lattice_ = Lattice_t();
+}
+
+PowerDiagramDynamic::Id_t PowerDiagramDynamic::insert(const Sphere_t& sphere)
+{
+    const auto id = addSphere(std::get<0>(sphere), std::get<1>(sphere));
+    place(id);
+
+    return id;
+}
+
+void PowerDiagramDynamic::erase(Id_t sphere)
+{
+    if (sphere >= states_.size() || states_[sphere] == State::Erased) {
+        throw std::invalid_argument("PowerDiagramDynamic: Unknown sphere " + std::to_string(sphere));
+    }
+
+    switch (states_[sphere]) {
+        case State::Pending:
+            pending_.erase(std::find(pending_.begin(), pending_.end(), sphere));
+            states_[sphere] = State::Erased;
+            break;
+        case State::Hidden: {
+            auto& hidden = simplices_[simplexOf_[sphere]].hidden;
+            hidden.erase(std::find(hidden.begin(), hidden.end(), sphere));
+            states_[sphere] = State::Erased;
+            break;
+        }
+        case State::Visible:
+            if (!eraseVisible(sphere)) {
+                // The neighborhood is degenerate or too small to be
+                // triangulated on its own.
+                states_[sphere] = State::Erased;
+                rebuild();
+            }
+            break;
+        case State::Erased:
+            // Rejected above.
+            break;
+    }
+
+    size_--;
+}
+
+PowerDiagramDynamic::Id_t PowerDiagramDynamic::addSphere(const VectorXd& center, double radius)
+{
+    if (dimension_ == 0) {
+        dimension_ = center.size();
+    }
+    assert(static_cast<size_t>(center.size()) == dimension_ && "All spheres need the same dimension.");
+
+    centers_.push_back(center);
+    radii_.push_back(radius);
+    states_.push_back(State::Pending);
+    simplexOf_.push_back(infinite);
+    keys_.push_back(0);
+    size_++;
+
+    return centers_.size() - 1;
+}
+
+/**
+ * @brief Put a sphere which is not part of the diagram yet into it.
+ */
+void PowerDiagramDynamic::place(Id_t sphere)
+{
+    if (simplices_.empty()) {
+        pending_.push_back(sphere);
+        triangulatePending();
+    } else {
+        insertSphere(sphere);
+    }
+}
+
+/**
+ * @brief Start the triangulation with a first simplex as soon as there are
+ * dimension + 1 affinely independent centers and insert the others.
+ */
+void PowerDiagramDynamic::triangulatePending()
+{
+    std::vector<Id_t> base{pending_[0]};
+    MatrixXd directions(dimension_, 0);
+    for (size_t i = 1; i < pending_.size() && base.size() <= dimension_; ++i) {
+        MatrixXd candidate(dimension_, base.size());
+        candidate.leftCols(base.size() - 1) = directions;
+        candidate.col(base.size() - 1) = centers_[pending_[i]] - centers_[base[0]];
+
+        Eigen::FullPivLU<MatrixXd> lu(candidate);
+        lu.setThreshold(orientationTolerance);
+        if (static_cast<size_t>(lu.rank()) == base.size()) {
+            base.push_back(pending_[i]);
+            directions.swap(candidate);
+        }
+    }
+    if (base.size() <= dimension_) {
+        return;
+    }
+
+    for (auto& vertex : base) {
+        makeVisible(vertex);
+    }
+
+    // The simplex and one infinite simplex on each of its facets.
+    const size_t first = createSimplex(base);
+    std::vector<size_t> outer(base.size());
+    for (size_t i = 0; i < base.size(); ++i) {
+        auto vertices = base;
+        vertices[i] = infinite;
+        outer[i] = createSimplex(vertices);
+    }
+    for (size_t i = 0; i < base.size(); ++i) {
+        simplices_[first].neighbors[i] = outer[i];
+        for (size_t j = 0; j < base.size(); ++j) {
+            simplices_[outer[i]].neighbors[j] = i == j ? first : outer[j];
+        }
+    }
+    hint_ = first;
+
+    std::vector<Id_t> rest;
+    for (auto& sphere : pending_) {
+        if (std::find(base.begin(), base.end(), sphere) == base.end()) {
+            rest.push_back(sphere);
+        }
+    }
+    pending_.clear();
+
+    for (auto& sphere : rest) {
+        insertSphere(sphere);
+    }
+}
+
+void PowerDiagramDynamic::insertSphere(Id_t sphere)
+{
+    const size_t start = locate(centers_[sphere]);
+    if (!conflicts(start, sphere)) {
+        hide(sphere, start);
+        return;
+    }
+
+    const auto region = conflictRegion(start, sphere);
+    makeVisible(sphere);
+    const auto created = fillCavity(region, sphere);
+
+    // Spheres of the region which are not part of the new simplices are
+    // hidden by the new sphere now.
+    std::vector<Id_t> kept;
+    for (auto& simplex : created) {
+        const auto& vertices = simplices_[simplex].vertices;
+        kept.insert(kept.end(), vertices.begin(), vertices.end());
+    }
+    std::sort(kept.begin(), kept.end());
+
+    std::vector<Id_t> removed;
+    std::vector<Id_t> hidden;
+    for (auto& simplex : region) {
+        for (auto& vertex : simplices_[simplex].vertices) {
+            if (vertex != infinite && !std::binary_search(kept.begin(), kept.end(), vertex)) {
+                removed.push_back(vertex);
+            }
+        }
+        const auto& simplexHidden = simplices_[simplex].hidden;
+        hidden.insert(hidden.end(), simplexHidden.begin(), simplexHidden.end());
+
+        destroySimplex(simplex);
+    }
+    std::sort(removed.begin(), removed.end());
+    removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+
+    for (auto& vertex : removed) {
+        if (maintainLattice_) {
+            lattice_.removeFace(keys_[vertex]);
+        }
+        hidden.push_back(vertex);
+    }
+
+    hint_ = created.front();
+    for (auto& other : hidden) {
+        insertSphere(other);
+    }
+}
+
+/**
+ * @brief Remove a sphere whose cell is not empty by triangulating its link,
+ * i.e. the spheres of all simplices around it, on its own. The simplices of
+ * this triangulation which would conflict with the sphere fill the hole.
+ *
+ * @return False if the link cannot be triangulated or does not fit into the
+ * hole. Nothing is changed in this case.
+ */
+bool PowerDiagramDynamic::eraseVisible(Id_t sphere)
+{
+    // Find all simplices around the sphere and the facets opposite of it.
+    ++epoch_;
+    std::vector<size_t> star{simplexOf_[sphere]};
+    simplices_[star[0]].visited = epoch_;
+    for (size_t k = 0; k < star.size(); ++k) {
+        const auto& simplex = simplices_[star[k]];
+        for (size_t i = 0; i < simplex.vertices.size(); ++i) {
+            const size_t neighbor = simplex.neighbors[i];
+            if (simplex.vertices[i] != sphere && simplices_[neighbor].visited != epoch_) {
+                simplices_[neighbor].visited = epoch_;
+                star.push_back(neighbor);
+            }
+        }
+    }
+
+    std::map<std::vector<Id_t>, std::pair<size_t, size_t>> boundary;
+    std::vector<Id_t> link;
+    for (auto& simplex : star) {
+        const auto& vertices = simplices_[simplex].vertices;
+        const size_t at = std::find(vertices.begin(), vertices.end(), sphere) - vertices.begin();
+        boundary[facetKey(vertices, at)] = std::make_pair(simplices_[simplex].neighbors[at], simplex);
+
+        for (auto& vertex : vertices) {
+            if (vertex != sphere && vertex != infinite) {
+                link.push_back(vertex);
+            }
+        }
+    }
+    std::sort(link.begin(), link.end());
+    link.erase(std::unique(link.begin(), link.end()), link.end());
+
+    // Triangulate the link. Local ids are positions in link.
+    PowerDiagramDynamic local(false);
+    for (auto& vertex : link) {
+        local.insert(PowerDiagram::sphere(centers_[vertex], radii_[vertex]));
+    }
+    for (size_t i = 0; i < link.size(); ++i) {
+        if (local.states_[i] != State::Visible) {
+            return false;
+        }
+    }
+
+    const auto localSphere = local.addSphere(centers_[sphere], radii_[sphere]);
+    const size_t start = local.locate(centers_[sphere]);
+    if (!local.conflicts(start, localSphere)) {
+        return false;
+    }
+    const auto region = local.conflictRegion(start, localSphere);
+
+    const auto toGlobal = [&link](Id_t vertex) {
+        return vertex == infinite ? infinite : link[vertex];
+    };
+
+    // The boundary of the region has to match the boundary of the star.
+    std::vector<std::vector<Id_t>> regionVertices(region.size());
+    std::unordered_map<size_t, size_t> positions;
+    size_t matched = 0;
+    for (size_t k = 0; k < region.size(); ++k) {
+        const auto& simplex = local.simplices_[region[k]];
+        positions[region[k]] = k;
+
+        regionVertices[k].resize(simplex.vertices.size());
+        std::transform(simplex.vertices.begin(), simplex.vertices.end(), regionVertices[k].begin(), toGlobal);
+
+        for (size_t i = 0; i < simplex.vertices.size(); ++i) {
+            if (!local.inRegion(simplex.neighbors[i])) {
+                if (boundary.count(facetKey(regionVertices[k], i)) == 0) {
+                    return false;
+                }
+                matched++;
+            }
+        }
+    }
+    if (matched != boundary.size()) {
+        return false;
+    }
+
+    // Fill the hole.
+    std::vector<size_t> created(region.size());
+    for (size_t k = 0; k < region.size(); ++k) {
+        created[k] = createSimplex(regionVertices[k]);
+    }
+    for (size_t k = 0; k < region.size(); ++k) {
+        const auto& neighbors = local.simplices_[region[k]].neighbors;
+        for (size_t i = 0; i < neighbors.size(); ++i) {
+            if (local.inRegion(neighbors[i])) {
+                simplices_[created[k]].neighbors[i] = created[positions.at(neighbors[i])];
+            } else {
+                const auto& outer = boundary.at(facetKey(regionVertices[k], i));
+                simplices_[created[k]].neighbors[i] = outer.first;
+                replaceNeighbor(outer.first, outer.second, created[k]);
+            }
+        }
+    }
+
+    std::vector<Id_t> hidden;
+    for (auto& simplex : star) {
+        const auto& simplexHidden = simplices_[simplex].hidden;
+        hidden.insert(hidden.end(), simplexHidden.begin(), simplexHidden.end());
+
+        destroySimplex(simplex);
+    }
+    if (maintainLattice_) {
+        lattice_.removeFace(keys_[sphere]);
+    }
+    states_[sphere] = State::Erased;
+
+    // Hidden spheres in the hole may have a cell now.
+    hint_ = created.front();
+    for (auto& other : hidden) {
+        insertSphere(other);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Triangulate all spheres from scratch.
+ */
+void PowerDiagramDynamic::rebuild()
+{
+    std::vector<Id_t> spheres;
+    for (size_t i = 0; i < states_.size(); ++i) {
+        if (states_[i] != State::Erased) {
+            states_[i] = State::Pending;
+            spheres.push_back(i);
+        }
+    }
+
+    pending_.clear();
+    simplices_.clear();
+    free_.clear();
+    hint_ = 0;
+    lattice_ = Lattice_t();
+
+    for (auto& sphere : spheres) {
+        place(sphere);
+    }
+}
+
+/**
+ * @brief Create a simplex with unlinked neighbors and add its 0-face to the
+ * lattice. All finite vertices need to be visible.
+ */
+size_t PowerDiagramDynamic::createSimplex(const std::vector<Id_t>& vertices)
+{
+    size_t index;
+    if (free_.empty()) {
+        index = simplices_.size();
+        simplices_.push_back(Simplex());
+    } else {
+        index = free_.back();
+        free_.pop_back();
+    }
+
+    auto& simplex = simplices_[index];
+    simplex.vertices = vertices;
+    simplex.neighbors.assign(vertices.size(), infinite);
+    simplex.infinite = std::find(vertices.begin(), vertices.end(), infinite) != vertices.end();
+    simplex.alive = true;
+    simplex.hidden.clear();
+    simplex.visited = 0;
+    simplex.conflict = false;
+
+    std::vector<Id_t> finite;
+    for (auto& vertex : vertices) {
+        if (vertex != infinite) {
+            finite.push_back(vertex);
+            simplexOf_[vertex] = index;
+        }
+    }
+
+    // The 0-face z = c_0 + E l lies in the affine hull of the centers and
+    // has the same power with respect to all spheres, i.e.
+    //   2 <c_j - c_0, z> = |c_j|^2 - r_j^2 - |c_0|^2 + r_0^2.
+    const auto& c0 = centers_[finite[0]];
+    const double w0 = c0.squaredNorm() - radii_[finite[0]] * radii_[finite[0]];
+    MatrixXd E(dimension_, finite.size() - 1);
+    VectorXd b(finite.size() - 1);
+    for (size_t j = 1; j < finite.size(); ++j) {
+        const auto& cj = centers_[finite[j]];
+        E.col(j - 1) = cj - c0;
+        b[j - 1] = cj.squaredNorm() - radii_[finite[j]] * radii_[finite[j]] - w0;
+    }
+
+    if (finite.size() == 1) {
+        simplex.point = c0;
+    } else if (!simplex.infinite) {
+        simplex.point = (2 * E.transpose()).fullPivLu().solve(b);
+    } else {
+        const VectorXd l = (2 * E.transpose() * E).fullPivLu().solve(b - 2 * E.transpose() * c0);
+        simplex.point = c0 + E * l;
+    }
+    simplex.power = power(finite[0], simplex.point);
+
+    if (maintainLattice_ && !simplex.infinite) {
+        Lattice_t::Keys_t keys;
+        for (auto& vertex : finite) {
+            keys.insert(keys_[vertex]);
+        }
+
+        simplex.face = lattice_.addMaximalFace(keys);
+        lattice_.value(simplex.face) = simplex.point;
+    }
+
+    return index;
+}
+
+void PowerDiagramDynamic::destroySimplex(size_t simplex)
+{
+    if (maintainLattice_ && !simplices_[simplex].infinite) {
+        lattice_.removeFace(simplices_[simplex].face);
+    }
+
+    simplices_[simplex].alive = false;
+    simplices_[simplex].hidden.clear();
+    free_.push_back(simplex);
+}
+
+void PowerDiagramDynamic::replaceNeighbor(size_t simplex, size_t from, size_t to)
+{
+    auto& neighbors = simplices_[simplex].neighbors;
+    *std::find(neighbors.begin(), neighbors.end(), from) = to;
+}
+
+void PowerDiagramDynamic::makeVisible(Id_t sphere)
+{
+    states_[sphere] = State::Visible;
+    if (maintainLattice_) {
+        keys_[sphere] = lattice_.addMinimal(centers_[sphere]);
+    }
+}
+
+void PowerDiagramDynamic::hide(Id_t sphere, size_t simplex)
+{
+    states_[sphere] = State::Hidden;
+    simplexOf_[sphere] = simplex;
+    simplices_[simplex].hidden.push_back(sphere);
+}
+
+double PowerDiagramDynamic::power(Id_t sphere, const VectorXd& point) const
+{
+    return (centers_[sphere] - point).squaredNorm() - radii_[sphere] * radii_[sphere];
+}
+
+/**
+ * @brief Signed volume of the simplex spanned by the finite facet and the
+ * point, or zero if the point lies on the hyperplane through the facet.
+ */
+double PowerDiagramDynamic::orientation(const std::vector<Id_t>& facet, const VectorXd& point) const
+{
+    const auto& c0 = centers_[facet[0]];
+
+    MatrixXd A(dimension_, dimension_);
+    double scale = 1;
+    for (size_t j = 1; j < facet.size(); ++j) {
+        A.row(j - 1) = (centers_[facet[j]] - c0).transpose();
+        scale *= A.row(j - 1).norm();
+    }
+    A.row(dimension_ - 1) = (point - c0).transpose();
+    scale *= A.row(dimension_ - 1).norm();
+
+    const double volume = A.determinant();
+    return std::abs(volume) <= orientationTolerance * scale ? 0 : volume;
+}
+
+/**
+ * @brief For an infinite simplex, find on which side of its finite facet the
+ * point lies.
+ *
+ * @return 1 if it lies outside of the convex hull, -1 if it lies inside and
+ * 0 if it lies on the hyperplane through the facet.
+ */
+int PowerDiagramDynamic::sideOfHull(size_t simplex, const VectorXd& point) const
+{
+    const auto& vertices = simplices_[simplex].vertices;
+    const size_t at = std::find(vertices.begin(), vertices.end(), infinite) - vertices.begin();
+    const auto& inner = simplices_[simplices_[simplex].neighbors[at]];
+
+    // The vertex of the finite neighbor which is not on the facet
+    const size_t opposite = std::find(inner.neighbors.begin(), inner.neighbors.end(), simplex)
+        - inner.neighbors.begin();
+
+    std::vector<Id_t> facet;
+    for (auto& vertex : vertices) {
+        if (vertex != infinite) {
+            facet.push_back(vertex);
+        }
+    }
+
+    const double outside = orientation(facet, point);
+    if (outside == 0) {
+        return 0;
+    }
+    return outside * orientation(facet, centers_[inner.vertices[opposite]]) < 0 ? 1 : -1;
+}
+
+VectorXd PowerDiagramDynamic::barycentric(size_t simplex, const VectorXd& point) const
+{
+    const auto& vertices = simplices_[simplex].vertices;
+    const auto& c0 = centers_[vertices[0]];
+
+    MatrixXd A(dimension_, dimension_);
+    for (size_t j = 1; j < vertices.size(); ++j) {
+        A.col(j - 1) = centers_[vertices[j]] - c0;
+    }
+
+    VectorXd lambda(vertices.size());
+    lambda.tail(dimension_) = A.fullPivLu().solve(point - c0);
+    lambda[0] = 1 - lambda.tail(dimension_).sum();
+
+    return lambda;
+}
+
+/**
+ * @brief Check if the 0-face of the simplex is removed by the sphere, i.e.
+ * if the sphere has a lower power there than the spheres of the simplex.
+ * Infinite simplices conflict with spheres outside of the convex hull, or
+ * on its boundary if they have a lower power at the 0-face of the facet.
+ */
+bool PowerDiagramDynamic::conflicts(size_t simplex, Id_t sphere) const
+{
+    const auto& candidate = simplices_[simplex];
+
+    if (candidate.infinite) {
+        const int side = sideOfHull(simplex, centers_[sphere]);
+        if (side != 0) {
+            return side > 0;
+        }
+    }
+
+    const double value = power(sphere, candidate.point);
+    const double tolerance = powerTolerance * (1 + std::abs(value) + std::abs(candidate.power));
+    return value < candidate.power - tolerance;
+}
+
+bool PowerDiagramDynamic::inRegion(size_t simplex) const
+{
+    return simplices_[simplex].visited == epoch_ && simplices_[simplex].conflict;
+}
+
+/**
+ * @brief Walk through the triangulation towards the point.
+ *
+ * @return A finite simplex containing the point or an infinite simplex
+ * whose facet separates it from the convex hull.
+ */
+size_t PowerDiagramDynamic::locate(const VectorXd& point)
+{
+    if (!simplices_[hint_].alive) {
+        hint_ = std::find_if(simplices_.begin(), simplices_.end(),
+                [](const Simplex& simplex) { return simplex.alive; }) - simplices_.begin();
+    }
+
+    size_t current = hint_;
+    for (size_t step = 0; step < simplices_.size() + 16; ++step) {
+        const auto& simplex = simplices_[current];
+
+        if (simplex.infinite) {
+            if (sideOfHull(current, point) > 0) {
+                return current;
+            }
+
+            const auto& vertices = simplex.vertices;
+            current = simplex.neighbors[std::find(vertices.begin(), vertices.end(), infinite) - vertices.begin()];
+            continue;
+        }
+
+        // Leave through some facet which has the point on its other side.
+        // Starting at a random facet makes sure the walk does not cycle.
+        const auto lambda = barycentric(current, point);
+        const size_t offset = random_() % lambda.size();
+        bool inside = true;
+        for (size_t k = 0; k < static_cast<size_t>(lambda.size()); ++k) {
+            const size_t i = (offset + k) % lambda.size();
+            if (lambda[i] < -barycentricTolerance) {
+                current = simplex.neighbors[i];
+                inside = false;
+                break;
+            }
+        }
+        if (inside) {
+            return current;
+        }
+    }
+
+    // The walk got stuck for numerical reasons, so search all simplices.
+    for (size_t i = 0; i < simplices_.size(); ++i) {
+        if (simplices_[i].alive && !simplices_[i].infinite &&
+                barycentric(i, point).minCoeff() >= -barycentricTolerance) {
+            return i;
+        }
+    }
+    for (size_t i = 0; i < simplices_.size(); ++i) {
+        if (simplices_[i].alive && simplices_[i].infinite && sideOfHull(i, point) > 0) {
+            return i;
+        }
+    }
+
+    return hint_;
+}
+
+/**
+ * @brief Find all simplices connected to start which conflict with the
+ * sphere. The neighbors of the region are marked as visited, too.
+ */
+std::vector<size_t> PowerDiagramDynamic::conflictRegion(size_t start, Id_t sphere)
+{
+    ++epoch_;
+    std::vector<size_t> region{start};
+    simplices_[start].visited = epoch_;
+    simplices_[start].conflict = true;
+
+    for (size_t k = 0; k < region.size(); ++k) {
+        for (auto& neighbor : simplices_[region[k]].neighbors) {
+            auto& simplex = simplices_[neighbor];
+            if (simplex.visited != epoch_) {
+                simplex.visited = epoch_;
+                simplex.conflict = conflicts(neighbor, sphere);
+                if (simplex.conflict) {
+                    region.push_back(neighbor);
+                }
+            }
+        }
+    }
+
+    return region;
+}
+
+/**
+ * @brief Connect every facet on the boundary of the conflict region to the
+ * sphere. The region itself is left untouched.
+ *
+ * @return The new simplices.
+ */
+std::vector<size_t> PowerDiagramDynamic::fillCavity(const std::vector<size_t>& region, Id_t sphere)
+{
+    std::vector<size_t> created;
+    // New facets through the sphere which still miss their second simplex.
+    std::map<std::vector<Id_t>, std::pair<size_t, size_t>> open;
+
+    for (auto& old : region) {
+        for (size_t i = 0; i < dimension_ + 1; ++i) {
+            const size_t outer = simplices_[old].neighbors[i];
+            if (inRegion(outer)) {
+                continue;
+            }
+
+            auto vertices = simplices_[old].vertices;
+            vertices[i] = sphere;
+            const size_t simplex = createSimplex(vertices);
+            simplices_[simplex].neighbors[i] = outer;
+            replaceNeighbor(outer, old, simplex);
+
+            for (size_t j = 0; j < vertices.size(); ++j) {
+                if (j == i) {
+                    continue;
+                }
+
+                const auto facet = facetKey(vertices, j);
+                const auto it = open.find(facet);
+                if (it == open.end()) {
+                    open[facet] = std::make_pair(simplex, j);
+                } else {
+                    simplices_[simplex].neighbors[j] = it->second.first;
+                    simplices_[it->second.first].neighbors[it->second.second] = simplex;
+                    open.erase(it);
+                }
+            }
+
+            created.push_back(simplex);
+        }
+    }
+    assert(open.empty() && "The cavity is not closed.");
+
+    return created;
+}
@@ -0,0 +1,152 @@
+#ifndef POWERDIAGRAMDYNAMIC_H
+#define POWERDIAGRAMDYNAMIC_H
+
+#include "IncidenceLattice.hpp"
+#include "PowerDiagram.hpp"
+
+#include <Eigen/Dense>
+#include <random>
+#include <vector>
+
+/**
+ * @brief A power diagram which is repaired locally when spheres are inserted
+ * or erased instead of being recomputed.
+ *
+ * We store the dual regular triangulation as simplices with links to their
+ * neighbors. Simplices containing a vertex at infinity close the
+ * triangulation off at the convex hull of the centers.
+ * Inserting a sphere removes all simplices whose 0-face has a larger power
+ * than the new sphere and connects the boundary of this cavity to the sphere
+ * (Bowyer-Watson). Erasing a sphere triangulates the spheres around it on
+ * their own and glues the part the sphere was covering into the hole.
+ * Both only touch the simplices around the updated sphere.
+ *
+ * The lattice has the same format as the one of PowerDiagramNaive: the
+ * minimals are the centers of all spheres with a non-empty cell, the
+ * maximals are the 0-faces. Degenerate 0-faces of more than dimension + 1
+ * spheres appear once per simplex of the triangulation.
+ */
+class PowerDiagramDynamic : public PowerDiagram {
+    public:
+        using Lattice_t = IncidenceLattice<Eigen::VectorXd>;
+        using Id_t = size_t;
+
+        PowerDiagramDynamic();
+        virtual ~PowerDiagramDynamic() { }
+
+        /**
+         * @brief Calculate the diagram by inserting the spheres one by one
+         * into an empty diagram.
+         */
+        using PowerDiagram::fromSpheres;
+        virtual IncidenceLattice<Eigen::VectorXd> fromSpheres(const Centers_t& centers, const Radii_t& radii);
+
+        /**
+         * @brief Add a sphere to the diagram.
+         *
+         * @return An id to erase the sphere with later on.
+         */
+        Id_t insert(const Sphere_t& sphere);
+        /**
+         * @brief Remove a sphere which has been inserted before.
+         *
+         * @throws std::invalid_argument If the id is unknown or has already
+         * been erased.
+         */
+        void erase(Id_t sphere);
+        void clear();
+
+        /**
+         * @brief Number of spheres in the diagram, including the ones with
+         * empty cells.
+         */
+        size_t size() const
+        {
+            return size_;
+        }
+        const Lattice_t& lattice() const
+        {
+            return lattice_;
+        }
+
+    private:
+        enum class State : char {
+            // Not part of the triangulation yet, since there are not enough
+            // affinely independent spheres.
+            Pending,
+            Visible,
+            // The cell of the sphere is empty.
+            Hidden,
+            Erased
+        };
+
+        struct Simplex {
+            // Ids of the spheres or infinite for the vertex at infinity.
+            std::vector<Id_t> vertices;
+            // neighbors[i] is the simplex opposite of vertices[i].
+            std::vector<size_t> neighbors;
+            // The 0-face of the spheres and its power. For infinite simplices,
+            // the 0-face of the finite spheres within their affine hull.
+            Eigen::VectorXd point;
+            double power;
+            bool infinite;
+            bool alive;
+            Lattice_t::Key_t face;
+            // Hidden spheres whose centers lie in this simplex.
+            std::vector<Id_t> hidden;
+            // Scratch space for searches, see epoch_.
+            size_t visited;
+            bool conflict;
+        };
+
+        // Local triangulations used while erasing have no lattice.
+        bool maintainLattice_;
+        size_t dimension_;
+        size_t size_;
+
+        std::vector<Eigen::VectorXd> centers_;
+        std::vector<double> radii_;
+        std::vector<State> states_;
+        // A simplex containing the sphere, or the one storing it if hidden.
+        std::vector<size_t> simplexOf_;
+        std::vector<Lattice_t::Key_t> keys_;
+        std::vector<Id_t> pending_;
+
+        std::vector<Simplex> simplices_;
+        std::vector<size_t> free_;
+        // Where to start searching for the next sphere.
+        size_t hint_;
+        // Simplices visited in the current search have visited == epoch_.
+        size_t epoch_;
+        std::minstd_rand random_;
+
+        Lattice_t lattice_;
+
+        explicit PowerDiagramDynamic(bool maintainLattice);
+
+        Id_t addSphere(const Eigen::VectorXd& center, double radius);
+        void place(Id_t sphere);
+        void triangulatePending();
+        void insertSphere(Id_t sphere);
+        bool eraseVisible(Id_t sphere);
+        void rebuild();
+
+        size_t createSimplex(const std::vector<Id_t>& vertices);
+        void destroySimplex(size_t simplex);
+        void replaceNeighbor(size_t simplex, size_t from, size_t to);
+        void makeVisible(Id_t sphere);
+        void hide(Id_t sphere, size_t simplex);
+
+        double power(Id_t sphere, const Eigen::VectorXd& point) const;
+        double orientation(const std::vector<Id_t>& facet, const Eigen::VectorXd& point) const;
+        int sideOfHull(size_t simplex, const Eigen::VectorXd& point) const;
+        Eigen::VectorXd barycentric(size_t simplex, const Eigen::VectorXd& point) const;
+        bool conflicts(size_t simplex, Id_t sphere) const;
+        bool inRegion(size_t simplex) const;
+
+        size_t locate(const Eigen::VectorXd& point);
+        std::vector<size_t> conflictRegion(size_t start, Id_t sphere);
+        std::vector<size_t> fillCavity(const std::vector<size_t>& region, Id_t sphere);
+};
+
+#endif
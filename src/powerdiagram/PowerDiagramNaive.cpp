@@ -1,139 +1,574 @@
 #include "PowerDiagramNaive.hpp"
 
 #include "AllChoices.hpp"
+#include "ConvexHullQuickhull.hpp"
+#include "FixedDimension.hpp"
+#include "Parallel.hpp"
+#include "PowerLocator.hpp"
+#include "SphereSet.hpp"
 
 #include <gflags/gflags.h>
+#include <algorithm>
 #include <iostream>
-#include <iterator>
+#include <limits>
+#include <mutex>
+#include <set>
 #include <unordered_map>
+#include <utility>
 
 DECLARE_bool(verbose);
 
 using Eigen::MatrixXd;
 using Eigen::VectorXd;
-using Hyperplane_t = std::tuple<VectorXd, double>;
-using Sphere_t = PowerDiagram::Sphere_t;
 
 /**
- * @brief For a group of spheres check whether they form a 0-face.
- *
- * @param spheres Vector of all spheres.
- * @param group The indices of the current group.
- *
- * @return A pair of a boolean signifying whether there is a 0-face and the
- * position if it exists.
+ * @brief The naive algorithm for spheres of a fixed dimension (or
+ * Eigen::Dynamic).
  */
-static std::pair<bool, VectorXd> possible0Face(
-        const std::vector<Sphere_t>& spheres,
-        const std::vector<size_t>& group)
-{
-    // Find all chordales needed to define the 0-face
-    std::vector<std::vector<size_t>> pairs;
-    for (size_t i = 1; i < group.size(); ++i) {
-        pairs.push_back({0, i});
+template <int Dimension>
+struct NaiveEngine {
+    using Center_t = Eigen::Matrix<double, Dimension, 1>;
+    using Sphere_t = PowerDiagram::FixedSphere_t<Dimension>;
+    using Spheres_t = std::vector<Sphere_t, Eigen::aligned_allocator<Sphere_t>>;
+    enum { Reduced = FixedDimension::Reduced<Dimension>::value };
+    // A group is a 0-face if no sphere has a lower power than its spheres by
+    // more than this.
+    //FIXME: This might cause numerical issues.
+    static constexpr double tolerance = 1e-3;
+
+    /**
+     * @brief The 0-faces found by one task, with the dimension + 1 indices
+     * of each group stored consecutively.
+     */
+    struct Found {
+        std::vector<size_t> groups;
+        std::vector<Center_t, Eigen::aligned_allocator<Center_t>> points;
+    };
+
+    /**
+     * @brief For a group of spheres check whether they form a 0-face.
+     *
+     * @param spheres Vector of all spheres.
+     * @param group The indices of the current group.
+     * @param point Set to the position of the 0-face if it exists.
+     *
+     * @return True if there is a 0-face.
+     */
+    static bool possible0Face(
+            const Spheres_t& spheres,
+            const std::vector<size_t>& group,
+            Center_t& point)
+    {
+        const auto dimension = std::get<0>(spheres[0]).size();
+
+        // Find all chordales needed to define the 0-face, i.e. the
+        // hyperplanes between the first sphere and every other sphere.
+        Eigen::Matrix<double, Dimension, Dimension> A;
+        Center_t b;
+        A.resize(group.size() - 1, dimension);
+        b.resize(group.size() - 1);
+
+        const auto& c1 = std::get<0>(spheres[group[0]]);
+        const double r1 = std::get<1>(spheres[group[0]]);
+        for (size_t i = 1; i < group.size(); ++i) {
+            const auto& c2 = std::get<0>(spheres[group[i]]);
+            const double r2 = std::get<1>(spheres[group[i]]);
+
+            A.row(i - 1) = 2 * (c1 - c2).transpose();
+            b[i - 1] = r2 * r2 - r1 * r1 - c2.dot(c2) + c1.dot(c1);
+        }
+
+        // Find the (possibly not existing) intersection of the chordales
+        point = A.fullPivLu().solve(b);
+        //Check if there actually is an intersection
+        //FIXME: This might cause numerical issues.
+        return (A * point).isApprox(b);
     }
 
-    std::vector<Hyperplane_t> planes(pairs.size());
-    std::transform(pairs.begin(), pairs.end(), planes.begin(),
-            [&spheres, &group](const std::vector<size_t>& pair) {
-                VectorXd c1, c2;
-                double r1, r2;
-                std::tie(c1, r1) = spheres[group[pair[0]]];
-                std::tie(c2, r2) = spheres[group[pair[1]]];
-
-                const VectorXd normal = 2 * (c1 - c2);
-                const double bias = r2 * r2 - r1 * r1 - c2.dot(c2) + c1.dot(c1);
-                return std::make_tuple(normal, bias);
-            });
+    /**
+     * @brief For a group of spheres and a possible 0-face location, check if it is
+     * actually part of the power diagram.
+     *
+     * @param locator Index of all spheres, used to search for a lower power.
+     * @param spheres Vector of all spheres.
+     * @param group The indices of the current group.
+     * @param point Location of the candidate 0-face.
+     *
+     * @return True if there is no sphere with lower power than the ones in group.
+     */
+    static bool is0Face(
+            const PowerLocator& locator,
+            const Spheres_t& spheres,
+            const std::vector<size_t>& group,
+            const Center_t& point)
+    {
+        const auto groupPower = PowerDiagram::power(spheres[group[0]], point);
 
-    // Find the (possibly not existing) intersection of the chordales
-    MatrixXd A(planes.size(), std::get<0>(planes[0]).size());
-    VectorXd b(planes.size());
+        return !locator.existsBelow(point, groupPower - tolerance);
+    }
 
-    for (size_t i = 0; i < planes.size(); ++i) {
-        A.row(i) = std::get<0>(planes[i]);
-        b[i] = std::get<1>(planes[i]);
+    /**
+     * @brief Check a sorted group and store it in result if it forms a
+     * 0-face.
+     */
+    static void check(
+            const PowerLocator& locator,
+            const Spheres_t& spheres,
+            const std::vector<size_t>& group,
+            Found& result)
+    {
+        Center_t point;
+        if (possible0Face(spheres, group, point) &&
+                is0Face(locator, spheres, group, point)) {
+            result.groups.insert(result.groups.end(), group.begin(), group.end());
+            result.points.push_back(point);
+        }
     }
 
-    const VectorXd result = A.fullPivLu().solve(b);
-    //Check if there actually is an intersection
-    //FIXME: This might cause numerical issues.
-    const bool hasSolution = (A * result).isApprox(b);
+    /**
+     * @brief Check the groups of dimension + 1 spheres with ranks in
+     * [begin, end) of the lexicographic order. The range is cut into equal
+     * chunks which are enumerated in place, so the threads get balanced work
+     * and memory only depends on the output.
+     */
+    static std::vector<Found> findAll(
+            const PowerLocator& locator,
+            const Spheres_t& spheres,
+            size_t begin,
+            size_t end)
+    {
+        const size_t dim = std::get<0>(spheres[0]).size();
 
-    return std::make_pair(hasSolution, result);
-}
+        end = std::min(end, AllChoices::countIndexGroups(dim + 1, spheres.size()));
+        begin = std::min(begin, end);
+        const size_t size = end - begin;
+        const size_t chunks = std::min(size, 64 * Parallel::threads());
+        const auto chunkBegin = [=](size_t chunk) {
+            return begin + size / chunks * chunk + std::min(chunk, size % chunks);
+        };
 
-/**
- * @brief For a group of spheres and a possible 0-face location, check if it is
- * actually part of the power diagram.
- *
- * @param spheres Vector of all spheres.
- * @param group The indices of the current group.
- * @param point Location of the candidate 0-face.
- *
- * @return True if there is no sphere with lower power than the ones in group.
- */
-static bool is0Face(
-        const std::vector<Sphere_t>& spheres,
-        const std::vector<size_t>& group,
-        const VectorXd& point)
-{
-    std::vector<double> powers(spheres.size());
-    std::transform(spheres.begin(), spheres.end(), powers.begin(),
-            [&point](const Sphere_t& sphere) {
-                return PowerDiagram::power(sphere, point);
+        // All groups before the first unfinished chunk have been checked,
+        // which is where to resume an interrupted run.
+        std::vector<bool> finished(chunks, false);
+        size_t unfinished = 0;
+        std::mutex progress;
+
+        std::vector<Found> found(chunks);
+        Parallel::forEach(chunks, [&](size_t chunk) {
+                AllChoices::forEachIndexGroup<size_t>(
+                    dim + 1,
+                    spheres.size(),
+                    chunkBegin(chunk),
+                    chunkBegin(chunk + 1),
+                    [&](const std::vector<size_t>& group) {
+                        check(locator, spheres, group, found[chunk]);
+                    });
+
+                if (FLAGS_verbose) {
+                    std::lock_guard<std::mutex> lock(progress);
+                    finished[chunk] = true;
+                    while (unfinished < chunks && finished[unfinished]) {
+                        ++unfinished;
+                    }
+                    std::cerr << "Checked all groups before " << chunkBegin(unfinished) << std::endl;
+                }
             });
 
-    const auto minimal = *std::min_element(powers.begin(), powers.end());
-    const auto groupPower = PowerDiagram::power(spheres[group[0]], point);
+        return found;
+    }
 
-    //FIXME: This might cause numerical issues.
-    return std::abs(groupPower - minimal) <= 1e-3;
-}
+    /**
+     * @brief Check only the groups of a sphere with dimension many of its
+     * power-nearest neighbors, i.e. the spheres with the lowest power at its
+     * center.
+     */
+    static std::vector<Found> findNear(
+            const PowerLocator& locator,
+            const Spheres_t& spheres,
+            size_t neighbors)
+    {
+        const size_t dim = std::get<0>(spheres[0]).size();
 
-IncidenceLattice<VectorXd> PowerDiagramNaive::fromSpheres(const std::vector<Sphere_t>& spheres)
-{
-    const size_t dim = std::get<0>(spheres[0]).size();
-
-    // Find all possible groups which might form a 0-face
-    std::vector<std::vector<size_t>> groups;
-    AllChoices::indexGroupsOfLength<size_t>(
-            dim + 1,
-            spheres.begin(),
-            spheres.end(),
-            std::back_inserter(groups));
-
-    IncidenceLattice<VectorXd> lattice;
-    std::unordered_map<size_t, decltype(lattice)::Key_t> vertexMap;
-
-    // For all the groups, check if they actually form a 0-face
-    for (auto& group : groups) {
-        bool hasSolution;
-        VectorXd point;
-        std::tie(hasSolution, point) = possible0Face(spheres, group);
-
-        if (hasSolution) {
-            const auto validFace = is0Face(spheres, group, point);
-
-            if (validFace) {
-                // Add the 0-face to the lattice
-                if (FLAGS_verbose) {
-                    std::cerr << "0-Face at: " << point.transpose() << std::endl;
+        std::vector<std::vector<size_t>> near(spheres.size());
+        Parallel::forEach(spheres.size(), [&](size_t sphere) {
+                auto& result = near[sphere];
+                locator.nearest(std::get<0>(spheres[sphere]), neighbors + 1, result);
+
+                result.erase(std::remove(result.begin(), result.end(), sphere), result.end());
+                result.resize(std::min(result.size(), neighbors));
+                std::sort(result.begin(), result.end());
+            });
+
+        // A group was checked by the smallest of its spheres which has all the
+        // others as neighbors.
+        const auto checkedBefore = [&near](const std::vector<size_t>& group, size_t sphere) {
+            for (auto& other : group) {
+                if (other >= sphere) {
+                    return false;
+                }
+
+                const auto& otherNear = near[other];
+                const bool all = std::all_of(group.begin(), group.end(), [&](size_t index) {
+                        return index == other ||
+                            std::binary_search(otherNear.begin(), otherNear.end(), index);
+                    });
+                if (all) {
+                    return true;
                 }
+            }
+            return false;
+        };
+
+        std::vector<Found> found(spheres.size());
+        Parallel::forEach(spheres.size(), [&](size_t first) {
+                const auto& candidates = near[first];
+                std::vector<size_t> rest;
+                std::vector<size_t> group(dim + 1);
+
+                for (bool more = AllChoices::firstIndexGroup(dim, candidates.size(), rest);
+                        more;
+                        more = AllChoices::nextIndexGroup(candidates.size(), rest)) {
+                    for (size_t i = 0; i < dim; ++i) {
+                        group[i] = candidates[rest[i]];
+                    }
+                    group[dim] = first;
+                    std::sort(group.begin(), group.end());
 
-                decltype(lattice)::Keys_t vertices;
-                for (auto& index : group) {
-                    if (vertexMap.count(index) <= 0) {
-                        vertexMap[index] = lattice.addMinimal(std::get<0>(spheres[index]));
+                    if (!checkedBefore(group, first)) {
+                        check(locator, spheres, group, found[first]);
                     }
+                }
+            });
+
+        return found;
+    }
+
+    /**
+     * @brief The spheres whose centers are vertices of the convex hull of
+     * all centers. A linear function on the centers is maximal at one of
+     * them.
+     */
+    static std::vector<size_t> hullVertices(const Spheres_t& spheres)
+    {
+        const size_t dimension = std::get<0>(spheres[0]).size();
+
+        MatrixXd centers(dimension, spheres.size());
+        for (size_t i = 0; i < spheres.size(); ++i) {
+            centers.col(i) = std::get<0>(spheres[i]);
+        }
+
+        std::vector<size_t> vertices;
+        if (dimension == 1) {
+            Eigen::DenseIndex lowest, highest;
+            centers.row(0).minCoeff(&lowest);
+            centers.row(0).maxCoeff(&highest);
+            vertices.push_back(lowest);
+            vertices.push_back(highest);
+            return vertices;
+        }
+
+        ConvexHullQuickhull hull;
+        ConvexHullAlgorithm::Indices_t indices;
+        hull.hullOf(centers, indices, ConvexHullAlgorithm::Part::Full);
+        for (auto& item : indices) {
+            vertices.push_back(item.second);
+        }
+        std::sort(vertices.begin(), vertices.end());
+
+        return vertices;
+    }
+
+    /**
+     * @brief A facet of a dual simplex whose partners are not searched yet,
+     * together with the 0-face of the simplex and its remaining sphere.
+     */
+    struct OpenFacet {
+        std::vector<size_t> facet;
+        size_t opposite;
+        Center_t point;
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    /**
+     * @brief Find all spheres which might form a 0-face with a facet, other
+     * than the one it has already.
+     *
+     * The points with equal power with respect to the spheres of the facet
+     * form a line through the known 0-face. A sphere forms a 0-face with the
+     * facet where it gets the same power as the facet's spheres, so that
+     * point has to be in the segment of the line where no sphere is lower by
+     * more than the tolerance. At one of the segment's ends, such a sphere
+     * has at most the facet's power.
+     * An end of the segment is found from the point where some sphere which
+     * gets lower in that direction is lower by the tolerance. That point is
+     * moved back to where the sphere of lowest power there is, until none is.
+     * Beyond the known 0-face, only the centers beyond the hyperplane through
+     * the facet's centers get lower, so if there are none, the facet is on
+     * the convex hull of the centers and the segment is unbounded. Otherwise,
+     * the hull vertex furthest beyond it gets lower eventually. Behind the
+     * known 0-face, the opposite sphere does.
+     *
+     * @param hull The spheres on the convex hull of the centers.
+     * @param candidates Set to the spheres with at most the facet's power,
+     * up to the tolerance, at the ends of the segment.
+     */
+    static void partnersOf(
+            const PowerLocator& locator,
+            const Spheres_t& spheres,
+            const std::vector<size_t>& hull,
+            const OpenFacet& open,
+            std::vector<size_t>& candidates)
+    {
+        const size_t dimension = std::get<0>(spheres[0]).size();
+        const auto& facet = open.facet;
+        const auto& first = std::get<0>(spheres[facet[0]]);
+
+        // The direction of the line, away from the opposite sphere.
+        Center_t direction;
+        if (dimension > 1) {
+            Eigen::Matrix<double, Reduced, Dimension> A;
+            A.resize(dimension - 1, dimension);
+            for (size_t i = 1; i < facet.size(); ++i) {
+                A.row(i - 1) = (std::get<0>(spheres[facet[i]]) - first).transpose();
+            }
+            direction = FixedDimension::kernelOf(A).normalized();
+        } else {
+            direction = Center_t::Ones(dimension);
+        }
+        if (direction.dot(std::get<0>(spheres[open.opposite]) - first) > 0) {
+            direction = -direction;
+        }
+
+        // The end of the segment in a direction, starting from a sphere which
+        // gets lower there.
+        const double facetPower = PowerDiagram::power(spheres[facet[0]], open.point);
+        const auto endOf = [&](const Center_t& towards, size_t sphere) {
+            // How far along the line a sphere is lower than the facet's
+            // spheres by the tolerance, or infinity if it never gets lower.
+            const auto lowerAt = [&](size_t other) {
+                const double slope = 2 * towards.dot(first - std::get<0>(spheres[other]));
+                if (slope >= 0) {
+                    return std::numeric_limits<double>::infinity();
+                }
+                return (PowerDiagram::power(spheres[other], open.point) - facetPower + tolerance) / -slope;
+            };
+
+            double distance = lowerAt(sphere);
+            Center_t point = open.point + distance * towards;
+            for (size_t step = 0; step < spheres.size(); ++step) {
+                double lowest;
+                const size_t lower = locator.locate(point, &lowest);
+                if (lower == sphere || lowest >= PowerDiagram::power(spheres[facet[0]], point) - tolerance) {
+                    break;
+                }
 
-                    vertices.insert(vertexMap[index]);
+                const double closer = lowerAt(lower);
+                if (!(closer < distance)) {
+                    break;
                 }
+                sphere = lower;
+                distance = closer;
+                point = open.point + distance * towards;
+            }
 
-                lattice.value(lattice.addMaximalFace(vertices)) = point;
+            std::vector<size_t> found;
+            locator.below(point, PowerDiagram::power(spheres[facet[0]], point) + tolerance, found);
+            candidates.insert(candidates.end(), found.begin(), found.end());
+        };
+
+        candidates.clear();
+        endOf(-direction, open.opposite);
+
+        double furthest = 1e-9;
+        size_t sphere = spheres.size();
+        for (auto& vertex : hull) {
+            const double side = direction.dot(std::get<0>(spheres[vertex]) - first);
+            if (side > furthest) {
+                furthest = side;
+                sphere = vertex;
             }
         }
+        if (sphere != spheres.size()) {
+            endOf(direction, sphere);
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
     }
 
-    return lattice;
+    /**
+     * @brief Add the 0-faces which are missing. The dual simplices of the
+     * 0-faces are connected by their facets, also where near-ties add more
+     * of them than a triangulation has. So all of them are found by searching
+     * the partners of every facet, including the ones of the 0-faces added on
+     * the way. This yields the same 0-faces as checking all groups, however
+     * many were found to start from.
+     *
+     * @return False if there was no 0-face to start from.
+     */
+    static bool complete(
+            const PowerLocator& locator,
+            const Spheres_t& spheres,
+            std::vector<Found>& found)
+    {
+        const size_t dim = std::get<0>(spheres[0]).size();
+
+        std::set<std::vector<size_t>> groups;
+        std::set<std::vector<size_t>> facets;
+        std::vector<OpenFacet, Eigen::aligned_allocator<OpenFacet>> unsearched;
+        const auto addFacets = [&](std::vector<size_t>::const_iterator group, const Center_t& point) {
+            std::vector<size_t> facet(dim);
+            for (size_t skip = 0; skip <= dim; ++skip) {
+                std::copy(group, group + skip, facet.begin());
+                std::copy(group + skip + 1, group + dim + 1, facet.begin() + skip);
+                if (facets.insert(facet).second) {
+                    unsearched.push_back(OpenFacet{facet, group[skip], point});
+                }
+            }
+        };
+
+        for (auto& result : found) {
+            for (size_t face = 0; face < result.points.size(); ++face) {
+                const auto group = result.groups.cbegin() + face * (dim + 1);
+                groups.insert(std::vector<size_t>(group, group + dim + 1));
+                addFacets(group, result.points[face]);
+            }
+        }
+
+        if (facets.empty()) {
+            return false;
+        }
+
+        const auto hull = hullVertices(spheres);
+
+        Found added;
+        std::vector<size_t> group(dim + 1);
+        std::vector<size_t> candidates;
+        Center_t point;
+        while (!unsearched.empty()) {
+            const auto open = unsearched.back();
+            unsearched.pop_back();
+
+            const auto& own = open.facet;
+            partnersOf(locator, spheres, hull, open, candidates);
+            for (auto& sphere : candidates) {
+                if (std::binary_search(own.begin(), own.end(), sphere)) {
+                    continue;
+                }
+
+                const auto position = std::lower_bound(own.begin(), own.end(), sphere);
+                std::copy(own.begin(), position, group.begin());
+                group[position - own.begin()] = sphere;
+                std::copy(position, own.end(), group.begin() + (position - own.begin()) + 1);
+
+                if (groups.count(group) <= 0 &&
+                        possible0Face(spheres, group, point) &&
+                        is0Face(locator, spheres, group, point)) {
+                    groups.insert(group);
+                    added.groups.insert(added.groups.end(), group.begin(), group.end());
+                    added.points.push_back(point);
+                    addFacets(added.groups.cend() - (dim + 1), point);
+                }
+            }
+        }
+
+        if (FLAGS_verbose) {
+            std::cerr << "Added " << added.points.size() << " missing 0-faces." << std::endl;
+        }
+        found.push_back(std::move(added));
+
+        return true;
+    }
+
+    static IncidenceLattice<VectorXd> run(
+            const PowerDiagram::Centers_t& centers,
+            const PowerDiagram::Radii_t& radii,
+            size_t neighbors,
+            size_t firstGroup,
+            size_t lastGroup)
+    {
+        const size_t dim = centers.rows();
+
+        Spheres_t spheres;
+        spheres.reserve(radii.size());
+        for (Eigen::Index i = 0; i < radii.size(); ++i) {
+            spheres.push_back(Sphere_t(centers.col(i), radii[i]));
+        }
+        const PowerLocator locator{SphereSet(centers, radii)};
+
+        // Widen the neighborhoods until there are 0-faces to start the
+        // completion from, at worst until all groups are checked.
+        std::vector<Found> found;
+        while (true) {
+            if (neighbors == 0) {
+                found = findAll(locator, spheres, firstGroup, lastGroup);
+                break;
+            }
+            if (neighbors + 1 >= spheres.size()) {
+                found = findAll(locator, spheres, 0, std::numeric_limits<size_t>::max());
+                break;
+            }
+
+            found = findNear(locator, spheres, neighbors);
+            if (complete(locator, spheres, found)) {
+                break;
+            }
+
+            neighbors *= 2;
+            if (FLAGS_verbose) {
+                std::cerr << "No 0-faces found, using " << neighbors << " neighbors." << std::endl;
+            }
+        }
+
+        // Merge in the order of the serial enumeration of all groups, so the
+        // keys do not depend on the number of threads or neighbors.
+        std::vector<std::pair<size_t, size_t>> order;
+        for (size_t task = 0; task < found.size(); ++task) {
+            for (size_t face = 0; face < found[task].points.size(); ++face) {
+                order.push_back(std::make_pair(task, face));
+            }
+        }
+        std::sort(order.begin(), order.end(),
+                [&found, dim](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+                    const auto first = found[a.first].groups.begin() + a.second * (dim + 1);
+                    const auto second = found[b.first].groups.begin() + b.second * (dim + 1);
+                    return std::lexicographical_compare(first, first + dim + 1, second, second + dim + 1);
+                });
+
+        IncidenceLattice<VectorXd>::Builder lattice;
+        std::unordered_map<size_t, IncidenceLattice<VectorXd>::Key_t> vertexMap;
+        for (auto& item : order) {
+            const auto& result = found[item.first];
+            const auto& point = result.points[item.second];
+
+            // Add the 0-face to the lattice
+            if (FLAGS_verbose) {
+                std::cerr << "0-Face at: " << point.transpose() << std::endl;
+            }
+
+            IncidenceLattice<VectorXd>::Keys_t vertices;
+            for (size_t i = 0; i <= dim; ++i) {
+                const auto index = result.groups[item.second * (dim + 1) + i];
+                if (vertexMap.count(index) <= 0) {
+                    vertexMap[index] = lattice.addMinimal(centers.col(index));
+                }
+
+                vertices.insert(vertexMap[index]);
+            }
+
+            lattice.value(lattice.addFace(vertices)) = point;
+        }
+
+        return lattice.build();
+    }
+};
+
+template <int Dimension>
+constexpr double NaiveEngine<Dimension>::tolerance;
+
+IncidenceLattice<VectorXd> PowerDiagramNaive::fromSpheres(const Centers_t& centers, const Radii_t& radii)
+{
+    return FixedDimension::dispatch<NaiveEngine>(
+            centers.rows(), centers, radii, neighbors_, firstGroup_, lastGroup_);
 }
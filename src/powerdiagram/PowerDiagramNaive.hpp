@@ -3,14 +3,39 @@
 
 #include "PowerDiagram.hpp"
 
+#include <limits>
+
 class PowerDiagramNaive : public PowerDiagram {
     public:
-        PowerDiagramNaive() { }
+        /**
+         * @param neighbors If not 0, only check groups of spheres which are
+         * among the neighbors many power-nearest neighbors of one of them.
+         * The 0-faces missed this way are searched next to the ones found,
+         * the neighborhoods are widened if there are none. The result is the
+         * same as without neighbors, they only decide how many 0-faces are
+         * found before searching next to them.
+         * @param firstGroup Without neighbors, only check the groups with
+         * ranks in [firstGroup, lastGroup) of the lexicographic order (see
+         * AllChoices::rankIndexGroup). This splits huge runs into parts
+         * whose diagrams contain the 0-faces of their groups.
+         */
+        explicit PowerDiagramNaive(
+                size_t neighbors = 0,
+                size_t firstGroup = 0,
+                size_t lastGroup = std::numeric_limits<size_t>::max()):
+            neighbors_(neighbors),
+            firstGroup_(firstGroup),
+            lastGroup_(lastGroup)
+        { }
         virtual ~PowerDiagramNaive() { }
 
-        virtual IncidenceLattice<Eigen::VectorXd> fromSpheres(const std::vector<PowerDiagram::Sphere_t>& spheres);
+        using PowerDiagram::fromSpheres;
+        virtual IncidenceLattice<Eigen::VectorXd> fromSpheres(const Centers_t& centers, const Radii_t& radii);
 
     private:
+        size_t neighbors_;
+        size_t firstGroup_;
+        size_t lastGroup_;
 };
 
 #endif
@@ -0,0 +1,427 @@
+#include "PowerLocator.hpp"
+
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+PowerLocator::PowerLocator(const SphereSet& spheres):
+    spheres_(spheres),
+    ids_(spheres.size()),
+    nodes_(),
+    lower_(),
+    upper_()
+{
+    std::iota(ids_.begin(), ids_.end(), 0);
+
+    build();
+}
+
+PowerLocator::PowerLocator(const IncidenceLattice<VectorXd>& diagram):
+    spheres_(),
+    ids_(),
+    nodes_(),
+    lower_(),
+    upper_()
+{
+    const auto& spheres = diagram.minimals();
+    const size_t dimension = spheres.empty() ? 0 : diagram.value(*spheres.begin()).size() - 1;
+
+    MatrixXd centers(dimension, spheres.size());
+    VectorXd radii(spheres.size());
+    ids_.assign(spheres.begin(), spheres.end());
+
+    for (size_t i = 0; i < ids_.size(); ++i) {
+        const auto& sphere = diagram.value(ids_[i]);
+        centers.col(i) = sphere.head(dimension);
+        radii[i] = sphere[dimension];
+    }
+    spheres_ = SphereSet(centers, radii);
+
+    build();
+}
+
+PowerLocator::PowerLocator(const MatrixXd& lifted):
+    spheres_(SphereSet::fromLifted(lifted)),
+    ids_(lifted.cols()),
+    nodes_(),
+    lower_(),
+    upper_()
+{
+    std::iota(ids_.begin(), ids_.end(), 0);
+
+    build();
+}
+
+void PowerLocator::build()
+{
+    nodes_.clear();
+    if (ids_.empty()) {
+        return;
+    }
+
+    // A balanced tree with leaves of at least leafSize / 2 spheres.
+    const size_t maxNodes = 2 * (ids_.size() / (leafSize / 2) + 1);
+    nodes_.reserve(maxNodes);
+    lower_.resize(dimension(), maxNodes);
+    upper_.resize(dimension(), maxNodes);
+
+    std::vector<size_t> order(ids_.size());
+    std::iota(order.begin(), order.end(), 0);
+    buildNode(0, ids_.size(), order);
+
+    lower_.conservativeResize(Eigen::NoChange, nodes_.size());
+    upper_.conservativeResize(Eigen::NoChange, nodes_.size());
+
+    // Store the spheres in tree order, so every node covers a contiguous
+    // range of them.
+    spheres_ = SphereSet(spheres_, order);
+    const std::vector<size_t> ids(ids_);
+    for (size_t i = 0; i < order.size(); ++i) {
+        ids_[i] = ids[order[i]];
+    }
+}
+
+size_t PowerLocator::buildNode(size_t begin, size_t end, std::vector<size_t>& order)
+{
+    const size_t node = nodes_.size();
+    nodes_.push_back(Node{begin, end, 0, 0, -std::numeric_limits<double>::infinity()});
+
+    lower_.col(node).setConstant(std::numeric_limits<double>::infinity());
+    upper_.col(node).setConstant(-std::numeric_limits<double>::infinity());
+    for (size_t i = begin; i < end; ++i) {
+        const auto center = spheres_.center(order[i]).transpose();
+        lower_.col(node) = lower_.col(node).cwiseMin(center);
+        upper_.col(node) = upper_.col(node).cwiseMax(center);
+        nodes_[node].maxRadius2 = std::max(nodes_[node].maxRadius2, spheres_.radius2(order[i]));
+    }
+
+    if (end - begin <= leafSize) {
+        return node;
+    }
+
+    // Split at the median of the widest extent.
+    Eigen::DenseIndex axis;
+    (upper_.col(node) - lower_.col(node)).maxCoeff(&axis);
+
+    const size_t split = begin + (end - begin) / 2;
+    const auto& coordinates = spheres_.coordinates();
+    std::nth_element(order.begin() + begin, order.begin() + split, order.begin() + end,
+            [&coordinates, axis](size_t a, size_t b) {
+                return coordinates(a, axis) < coordinates(b, axis);
+            });
+
+    const size_t left = buildNode(begin, split, order);
+    const size_t right = buildNode(split, end, order);
+    nodes_[node].left = left;
+    nodes_[node].right = right;
+
+    return node;
+}
+
+double PowerLocator::lowerBound(size_t node, const Eigen::Ref<const VectorXd>& point) const
+{
+    const double distance2 = (lower_.col(node) - point).cwiseMax(point - upper_.col(node))
+        .cwiseMax(0.0).squaredNorm();
+
+    return distance2 - nodes_[node].maxRadius2;
+}
+
+double PowerLocator::upperBound(size_t node, const Eigen::Ref<const VectorXd>& normal) const
+{
+    // The lift is separable: every coordinate contributes
+    // normal[i] * x + slope * x^2 on its own, maximized at its vertex.
+    const size_t dimension = this->dimension();
+    const double slope = normal[dimension];
+
+    double bound = -slope * nodes_[node].maxRadius2;
+    for (size_t i = 0; i < dimension; ++i) {
+        double x;
+        if (slope < 0) {
+            x = std::min(std::max(normal[i] / (-2 * slope), lower_(i, node)), upper_(i, node));
+        } else {
+            x = normal[i] > 0 ? upper_(i, node) : lower_(i, node);
+        }
+        bound += normal[i] * x + slope * x * x;
+    }
+
+    return bound;
+}
+
+size_t PowerLocator::locate(const Eigen::Ref<const VectorXd>& point, double* power) const
+{
+    assert(size() > 0 && "There is no minimum of no spheres.");
+    assert(static_cast<size_t>(point.size()) == dimension() && "Dimensions do not match.");
+
+    // Depth first, nearer child first. The depth of the tree is logarithmic,
+    // so the stack easily fits in here.
+    struct Entry {
+        size_t node;
+        double bound;
+    };
+    Entry stack[128];
+    size_t top = 0;
+    stack[top++] = Entry{0, lowerBound(0, point)};
+
+    LeafPowers_t powers;
+    double best = std::numeric_limits<double>::infinity();
+    size_t bestSphere = 0;
+    while (top > 0) {
+        const Entry entry = stack[--top];
+        if (entry.bound >= best) {
+            continue;
+        }
+
+        const Node& node = nodes_[entry.node];
+        if (node.left == 0) {
+            leafPowers(node, point, powers);
+            Eigen::DenseIndex index;
+            const double value = powers.minCoeff(&index);
+            if (value < best) {
+                best = value;
+                bestSphere = node.begin + index;
+            }
+            continue;
+        }
+
+        Entry near{node.left, lowerBound(node.left, point)};
+        Entry far{node.right, lowerBound(node.right, point)};
+        if (far.bound < near.bound) {
+            std::swap(near, far);
+        }
+        if (far.bound < best) {
+            stack[top++] = far;
+        }
+        if (near.bound < best) {
+            stack[top++] = near;
+        }
+    }
+
+    if (power != nullptr) {
+        *power = best;
+    }
+    return ids_[bestSphere];
+}
+
+void PowerLocator::nearest(
+        const Eigen::Ref<const VectorXd>& point,
+        size_t count,
+        std::vector<size_t>& nearest) const
+{
+    assert(static_cast<size_t>(point.size()) == dimension() && "Dimensions do not match.");
+
+    // A max-heap of the best spheres so far. Once it is full, its top is the
+    // power to beat.
+    std::vector<std::pair<double, size_t>> best;
+    best.reserve(count + 1);
+    const auto bound = [&best, count]() {
+        return best.size() < count ? std::numeric_limits<double>::infinity() : best.front().first;
+    };
+
+    struct Entry {
+        size_t node;
+        double bound;
+    };
+    Entry stack[128];
+    size_t top = 0;
+    if (!nodes_.empty() && count > 0) {
+        stack[top++] = Entry{0, lowerBound(0, point)};
+    }
+
+    LeafPowers_t powers;
+    while (top > 0) {
+        const Entry entry = stack[--top];
+        if (entry.bound >= bound()) {
+            continue;
+        }
+
+        const Node& node = nodes_[entry.node];
+        if (node.left == 0) {
+            leafPowers(node, point, powers);
+            for (size_t i = node.begin; i < node.end; ++i) {
+                const double value = powers[i - node.begin];
+                if (value < bound()) {
+                    best.push_back(std::make_pair(value, i));
+                    std::push_heap(best.begin(), best.end());
+                    if (best.size() > count) {
+                        std::pop_heap(best.begin(), best.end());
+                        best.pop_back();
+                    }
+                }
+            }
+            continue;
+        }
+
+        Entry near{node.left, lowerBound(node.left, point)};
+        Entry far{node.right, lowerBound(node.right, point)};
+        if (far.bound < near.bound) {
+            std::swap(near, far);
+        }
+        if (far.bound < bound()) {
+            stack[top++] = far;
+        }
+        if (near.bound < bound()) {
+            stack[top++] = near;
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end());
+    nearest.resize(best.size());
+    for (size_t i = 0; i < best.size(); ++i) {
+        nearest[i] = ids_[best[i].second];
+    }
+}
+
+bool PowerLocator::existsBelow(const Eigen::Ref<const VectorXd>& point, double threshold) const
+{
+    assert(static_cast<size_t>(point.size()) == dimension() && "Dimensions do not match.");
+
+    if (nodes_.empty()) {
+        return false;
+    }
+
+    // Like locate, but the bound to beat stays fixed.
+    size_t stack[128];
+    size_t top = 0;
+    stack[top++] = 0;
+
+    LeafPowers_t powers;
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+        if (node.left == 0) {
+            leafPowers(node, point, powers);
+            if (powers.minCoeff() < threshold) {
+                return true;
+            }
+            continue;
+        }
+
+        const double leftBound = lowerBound(node.left, point);
+        const double rightBound = lowerBound(node.right, point);
+        size_t near = node.left;
+        size_t far = node.right;
+        if (rightBound < leftBound) {
+            std::swap(near, far);
+        }
+        if (std::max(leftBound, rightBound) < threshold) {
+            stack[top++] = far;
+        }
+        if (std::min(leftBound, rightBound) < threshold) {
+            stack[top++] = near;
+        }
+    }
+
+    return false;
+}
+
+bool PowerLocator::existsBeyond(
+        const Eigen::Ref<const VectorXd>& normal,
+        double offset,
+        const std::vector<size_t>& except,
+        size_t* beyond) const
+{
+    assert(static_cast<size_t>(normal.size()) == dimension() + 1 && "Dimensions do not match.");
+    assert(normal[dimension()] <= 0 && "The hyperplane has to face downwards.");
+
+    if (nodes_.empty()) {
+        return false;
+    }
+
+    const size_t dimension = this->dimension();
+    const double slope = normal[dimension];
+
+    // Without beyond the search stops at the first sphere found, otherwise
+    // it continues for the furthest one.
+    bool found = false;
+    double furthest = offset;
+
+    size_t stack[128];
+    size_t top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+        if (node.left == 0) {
+            for (size_t i = node.begin; i < node.end; ++i) {
+                const auto center = spheres_.center(i).transpose();
+                const double value = normal.head(dimension).dot(center) +
+                    slope * (center.squaredNorm() - spheres_.radius2(i));
+                if (value >= furthest && !std::binary_search(except.begin(), except.end(), ids_[i])) {
+                    if (beyond == nullptr) {
+                        return true;
+                    }
+                    *beyond = ids_[i];
+                    found = true;
+                    furthest = value;
+                }
+            }
+            continue;
+        }
+
+        if (upperBound(node.right, normal) >= furthest) {
+            stack[top++] = node.right;
+        }
+        if (upperBound(node.left, normal) >= furthest) {
+            stack[top++] = node.left;
+        }
+    }
+
+    return found;
+}
+
+void PowerLocator::below(
+        const Eigen::Ref<const VectorXd>& point,
+        double threshold,
+        std::vector<size_t>& below) const
+{
+    assert(static_cast<size_t>(point.size()) == dimension() && "Dimensions do not match.");
+
+    below.clear();
+    if (nodes_.empty()) {
+        return;
+    }
+
+    // Like existsBelow, but all subtrees which may hold such a sphere are
+    // searched.
+    size_t stack[128];
+    size_t top = 0;
+    stack[top++] = 0;
+
+    LeafPowers_t powers;
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+        if (node.left == 0) {
+            leafPowers(node, point, powers);
+            for (size_t i = node.begin; i < node.end; ++i) {
+                if (powers[i - node.begin] < threshold) {
+                    below.push_back(ids_[i]);
+                }
+            }
+            continue;
+        }
+
+        if (lowerBound(node.left, point) < threshold) {
+            stack[top++] = node.left;
+        }
+        if (lowerBound(node.right, point) < threshold) {
+            stack[top++] = node.right;
+        }
+    }
+}
+
+std::vector<size_t> PowerLocator::locateAll(const MatrixXd& points) const
+{
+    std::vector<size_t> owners(points.cols());
+
+    Parallel::forEach(owners.size(), [&](size_t i) {
+            owners[i] = locate(points.col(i));
+        }, 1024);
+
+    return owners;
+}
@@ -0,0 +1,148 @@
+#ifndef POWERLOCATOR_H
+#define POWERLOCATOR_H
+
+#include "IncidenceLattice.hpp"
+#include "SphereSet.hpp"
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Answers which sphere has minimal power at given points, i.e. which
+ * power cell the points lie in.
+ *
+ * The spheres are stored in a kd-tree whose nodes know the bounding box of
+ * their centers and the largest squared radius below them. Since
+ *   pow(x, (c, r)) >= dist(x, box)^2 - max r^2
+ * for all spheres in a node, whole subtrees can be skipped once a sphere with
+ * lower power has been found. The spheres of a leaf are contiguous in a
+ * SphereSet, whose batch kernel computes all their powers at once.
+ */
+class PowerLocator {
+    public:
+        /**
+         * @brief Index all spheres of a set. Results are indices into the set.
+         */
+        explicit PowerLocator(const SphereSet& spheres);
+        /**
+         * @brief Index the spheres of a diagram computed by
+         * PowerDiagramDual, whose minimals store the center with the radius
+         * appended. Results are keys of these minimals.
+         */
+        explicit PowerLocator(const IncidenceLattice<Eigen::VectorXd>& diagram);
+        /**
+         * @brief Index weighted points given by their lifts (x, |x|^2 - w),
+         * one per column, as spheres with center x and squared radius w,
+         * which may be negative. Results are column indices.
+         */
+        explicit PowerLocator(const Eigen::MatrixXd& lifted);
+        virtual ~PowerLocator() { }
+
+        size_t size() const
+        {
+            return ids_.size();
+        }
+        size_t dimension() const
+        {
+            return spheres_.dimension();
+        }
+
+        /**
+         * @brief Find a sphere with minimal power at point. Ties are broken
+         * arbitrarily.
+         *
+         * @param power If not null, set to the minimal power.
+         *
+         * @return The index (or key) of the sphere.
+         */
+        size_t locate(const Eigen::Ref<const Eigen::VectorXd>& point, double* power = nullptr) const;
+
+        /**
+         * @brief Find the count spheres with the lowest power at point.
+         *
+         * @param nearest Set to their indices (or keys), by increasing power.
+         */
+        void nearest(
+                const Eigen::Ref<const Eigen::VectorXd>& point,
+                size_t count,
+                std::vector<size_t>& nearest) const;
+
+        /**
+         * @brief Check whether any sphere has a power below threshold at
+         * point. The search stops at the first such sphere, so this is
+         * usually much cheaper than locate if there is one close by.
+         */
+        bool existsBelow(const Eigen::Ref<const Eigen::VectorXd>& point, double threshold) const;
+        /**
+         * @brief Check whether the lift (c, |c|^2 - r^2) of any sphere other
+         * than the ones in except lies beyond a hyperplane, i.e. has
+         * normal.dot(lift) >= offset. The lifts are evaluated directly, so
+         * unlike the power queries this stays accurate for nearly vertical
+         * hyperplanes.
+         *
+         * @param normal Its last coordinate must not be positive, e.g. the
+         * outward normal of a lower facet or a horizontal vector.
+         * @param except Sorted indices (or keys).
+         * @param beyond If not null, set to the index (or key) of the sphere
+         * furthest beyond, which takes longer than finding any.
+         */
+        bool existsBeyond(
+                const Eigen::Ref<const Eigen::VectorXd>& normal,
+                double offset,
+                const std::vector<size_t>& except,
+                size_t* beyond = nullptr) const;
+        /**
+         * @brief Find all spheres with a power below threshold at point.
+         *
+         * @param below Set to their indices (or keys), in no particular order.
+         */
+        void below(
+                const Eigen::Ref<const Eigen::VectorXd>& point,
+                double threshold,
+                std::vector<size_t>& below) const;
+
+        /**
+         * @brief Locate many points, given as the columns of a matrix, on
+         * all threads.
+         */
+        std::vector<size_t> locateAll(const Eigen::MatrixXd& points) const;
+
+    private:
+        struct Node {
+            // Range of spheres (in tree order) below this node.
+            size_t begin;
+            size_t end;
+            // Children, or 0 for leaves (the root is never a child).
+            size_t left;
+            size_t right;
+            double maxRadius2;
+        };
+        enum { leafSize = 8 };
+        // Powers of all spheres of a leaf, on the stack.
+        using LeafPowers_t = Eigen::Matrix<double, Eigen::Dynamic, 1, 0, leafSize, 1>;
+
+        // Spheres in tree order.
+        SphereSet spheres_;
+        // Ids returned to the user, in tree order.
+        std::vector<size_t> ids_;
+
+        std::vector<Node> nodes_;
+        // Bounding boxes of the nodes, one column per node.
+        Eigen::MatrixXd lower_;
+        Eigen::MatrixXd upper_;
+
+        void build();
+        size_t buildNode(size_t begin, size_t end, std::vector<size_t>& order);
+        double lowerBound(size_t node, const Eigen::Ref<const Eigen::VectorXd>& point) const;
+        double upperBound(size_t node, const Eigen::Ref<const Eigen::VectorXd>& normal) const;
+        void leafPowers(
+                const Node& node,
+                const Eigen::Ref<const Eigen::VectorXd>& point,
+                LeafPowers_t& powers) const
+        {
+            spheres_.powers(node.begin, node.end - node.begin, point, powers);
+        }
+};
+
+#endif
@@ -0,0 +1,252 @@
+#ifndef SIMPLICIALHULL_H
+#define SIMPLICIALHULL_H
+
+#include "ConvexHullAlgorithm.hpp"
+#include "IncidenceLattice.hpp"
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The facets of a convex hull as simplices with links to their
+ * neighbors, like the ones built by quickhull.
+ *
+ * Neighboring simplices in the same hyperplane are merged into one facet
+ * when building the lattice. ConvexHullQuickhull and ConvexHullParallel
+ * both use this, so they merge nearly coplanar points alike.
+ *
+ * @tparam Dimension Dimension of the points, or Eigen::Dynamic.
+ */
+template <int Dimension>
+struct SimplicialHull {
+    using Lattice_t = IncidenceLattice<Eigen::VectorXd>;
+    using Point_t = Eigen::Matrix<double, Dimension, 1>;
+    static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+    // Facet f has the vertices vertices[f * dimension + i]. The facet
+    // opposite of vertex i, i.e. sharing all other vertices, is
+    // neighbors[f * dimension + i], or none if it is not part of the
+    // simplices, e.g. at the boundary of a lower hull.
+    std::vector<size_t> vertices;
+    std::vector<size_t> neighbors;
+    // Outward unit normals and offsets, a point x is outside of facet f
+    // if normals[f].dot(x) > offsets[f].
+    std::vector<Point_t, Eigen::aligned_allocator<Point_t>> normals;
+    std::vector<double> offsets;
+    // Facets which are not alive are ignored.
+    std::vector<bool> alive;
+
+    /**
+     * @brief Merge the facets in the same hyperplanes and build the lattice
+     * of the (requested part of the) hull from them.
+     *
+     * @param epsilon Points closer to a hyperplane than this are considered
+     * to be in it.
+     */
+    Lattice_t lattice(
+            const Eigen::MatrixXd& points,
+            double epsilon,
+            ConvexHullAlgorithm::Part part,
+            ConvexHullAlgorithm::Indices_t& indices) const
+    {
+        const size_t dimension = points.rows();
+        const size_t facets = alive.size();
+        const auto point = [&points, dimension](size_t index) {
+            return Eigen::Map<const Point_t>(points.data() + index * dimension, dimension);
+        };
+        const auto distance = [&](size_t facet, size_t index) {
+            return normals[facet].dot(point(index)) - offsets[facet];
+        };
+
+        std::vector<size_t> parent(facets);
+        std::iota(parent.begin(), parent.end(), 0);
+        const auto root = [&parent](size_t facet) {
+            while (parent[facet] != facet) {
+                facet = parent[facet] = parent[parent[facet]];
+            }
+            return facet;
+        };
+
+        for (size_t facet = 0; facet < facets; ++facet) {
+            if (!alive[facet]) {
+                continue;
+            }
+
+            for (size_t i = 0; i < dimension; ++i) {
+                const size_t other = neighbors[facet * dimension + i];
+                if (other == none || other < facet) {
+                    continue;
+                }
+
+                // The vertex of the neighbor which is not in this facet
+                // has to be in its hyperplane and vice versa.
+                size_t apart = none;
+                for (size_t j = 0; j < dimension; ++j) {
+                    if (neighbors[other * dimension + j] == facet) {
+                        apart = vertices[other * dimension + j];
+                    }
+                }
+
+                if (std::abs(distance(facet, apart)) <= epsilon &&
+                        std::abs(distance(other, vertices[facet * dimension + i])) <= epsilon &&
+                        normals[facet].dot(normals[other]) > 0) {
+                    parent[root(other)] = root(facet);
+                }
+            }
+        }
+
+        // Number the merged facets in the order of their first facet.
+        std::vector<size_t> groupOf(facets, none);
+        std::vector<std::vector<size_t>> groupVertices;
+        std::vector<Point_t, Eigen::aligned_allocator<Point_t>> groupNormals;
+        for (size_t facet = 0; facet < facets; ++facet) {
+            if (!alive[facet]) {
+                continue;
+            }
+
+            const size_t first = root(facet);
+            if (groupOf[first] == none) {
+                groupOf[first] = groupVertices.size();
+                groupVertices.emplace_back();
+                groupNormals.push_back(Point_t::Zero(dimension));
+            }
+            groupOf[facet] = groupOf[first];
+
+            auto& group = groupVertices[groupOf[facet]];
+            for (size_t i = 0; i < dimension; ++i) {
+                group.push_back(vertices[facet * dimension + i]);
+            }
+            groupNormals[groupOf[facet]] += normals[facet];
+        }
+
+        std::vector<bool> kept(groupVertices.size());
+        for (size_t group = 0; group < groupVertices.size(); ++group) {
+            groupNormals[group].normalize();
+            kept[group] = part == ConvexHullAlgorithm::Part::Full ||
+                groupNormals[group][dimension - 1] < 0;
+        }
+
+        // Merging can leave points inside of the merged facets or their
+        // faces, which are no vertices of the hull. At a vertex, the
+        // normals of the merged facets span the whole space. The facets
+        // beyond a missing neighbor are unknown, so the vertices there are
+        // kept.
+        std::vector<std::vector<size_t>> groupsAt(points.cols());
+        std::vector<bool> isVertex(points.cols(), false);
+        for (size_t facet = 0; facet < facets; ++facet) {
+            if (alive[facet]) {
+                for (size_t i = 0; i < dimension; ++i) {
+                    groupsAt[vertices[facet * dimension + i]].push_back(groupOf[facet]);
+
+                    if (neighbors[facet * dimension + i] == none) {
+                        for (size_t j = 0; j < dimension; ++j) {
+                            if (j != i) {
+                                isVertex[vertices[facet * dimension + j]] = true;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        for (size_t index = 0; index < groupsAt.size(); ++index) {
+            auto& groups = groupsAt[index];
+            std::sort(groups.begin(), groups.end());
+            groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+            if (isVertex[index] || groups.size() < dimension) {
+                continue;
+            }
+
+            Eigen::MatrixXd groupNormalsAt(dimension, groups.size());
+            for (size_t i = 0; i < groups.size(); ++i) {
+                groupNormalsAt.col(i) = groupNormals[groups[i]];
+            }
+            isVertex[index] = static_cast<size_t>(groupNormalsAt.fullPivLu().rank()) == dimension;
+        }
+
+        // The ridges between two merged facets consist of all ridges
+        // between their facets. Ridges without a neighbor stay on their own.
+        std::map<std::pair<size_t, size_t>, std::vector<size_t>> ridges;
+        std::vector<std::vector<size_t>> openRidges;
+        for (size_t facet = 0; facet < facets; ++facet) {
+            if (!alive[facet]) {
+                continue;
+            }
+
+            for (size_t i = 0; i < dimension; ++i) {
+                const size_t other = neighbors[facet * dimension + i];
+                const size_t group = groupOf[facet];
+                std::vector<size_t>* ridge;
+                if (other == none) {
+                    if (!kept[group]) {
+                        continue;
+                    }
+
+                    openRidges.emplace_back();
+                    ridge = &openRidges.back();
+                } else {
+                    const size_t otherGroup = groupOf[other];
+                    if (other < facet || group == otherGroup || !(kept[group] || kept[otherGroup])) {
+                        continue;
+                    }
+
+                    ridge = &ridges[std::make_pair(std::min(group, otherGroup), std::max(group, otherGroup))];
+                }
+
+                for (size_t j = 0; j < dimension; ++j) {
+                    if (j != i) {
+                        ridge->push_back(vertices[facet * dimension + j]);
+                    }
+                }
+            }
+        }
+
+        // Create the incidence lattice
+        Lattice_t::Builder lattice;
+        std::vector<Lattice_t::Key_t> keyOf(points.cols(), none);
+        indices.clear();
+        const auto keys = [&](std::vector<size_t>& group) {
+            std::sort(group.begin(), group.end());
+            group.erase(std::unique(group.begin(), group.end()), group.end());
+
+            Lattice_t::Keys_t result;
+            for (auto& index : group) {
+                if (!isVertex[index]) {
+                    continue;
+                }
+                if (keyOf[index] == none) {
+                    keyOf[index] = lattice.addMinimal(Eigen::VectorXd(point(index)));
+                    indices[keyOf[index]] = index;
+                }
+                result.insert(keyOf[index]);
+            }
+            return result;
+        };
+
+        for (size_t group = 0; group < groupVertices.size(); ++group) {
+            if (kept[group]) {
+                lattice.value(lattice.addFace(keys(groupVertices[group]))) =
+                    Eigen::VectorXd(groupNormals[group]);
+            }
+        }
+        for (auto& item : ridges) {
+            lattice.addFace(keys(item.second));
+        }
+        for (auto& ridge : openRidges) {
+            lattice.addFace(keys(ridge));
+        }
+
+        return lattice.build();
+    }
+};
+
+template <int Dimension>
+constexpr size_t SimplicialHull<Dimension>::none;
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef SPHERESET_H
+#define SPHERESET_H
+
+#include "PowerDiagram.hpp"
+
+#include <Eigen/Dense>
+#include <cassert>
+#include <vector>
+
+/**
+ * @brief A set of spheres stored as structure of arrays.
+ *
+ * Coordinates are stored column-wise, i.e. the i-th coordinate of all
+ * spheres is contiguous, next to the squared radii. The powers of one point
+ * with respect to a range of spheres are then computed one coordinate at a
+ * time over all of them, which Eigen vectorizes (SSE, AVX2 or AVX-512,
+ * depending on the target architecture, see WITH_NATIVE_ARCH).
+ * Squared radii may be negative, so weighted points can be stored as well.
+ *
+ * The set itself only evaluates contiguous ranges of spheres, e.g. the
+ * leaves of a PowerLocator. Finding the sphere of minimal power at a point,
+ * or all below a threshold, goes through PowerLocator, which skips most of
+ * the spheres instead of evaluating all of them.
+ */
+class SphereSet {
+    public:
+        SphereSet():
+            coordinates_(),
+            radii2_()
+        { }
+        explicit SphereSet(const std::vector<PowerDiagram::Sphere_t>& spheres):
+            coordinates_(),
+            radii2_()
+        {
+            const size_t dimension = spheres.empty() ? 0 : std::get<0>(spheres[0]).size();
+            coordinates_.resize(spheres.size(), dimension);
+            radii2_.resize(spheres.size());
+
+            for (size_t i = 0; i < spheres.size(); ++i) {
+                coordinates_.row(i) = std::get<0>(spheres[i]).transpose();
+                radii2_[i] = std::get<1>(spheres[i]) * std::get<1>(spheres[i]);
+            }
+        }
+        /**
+         * @brief Create a set from a matrix whose columns are the centers,
+         * like the ones read by FromCSV::read.
+         */
+        SphereSet(const PowerDiagram::Centers_t& centers, const PowerDiagram::Radii_t& radii):
+            coordinates_(centers.transpose()),
+            radii2_(radii.cwiseAbs2())
+        {
+            assert(centers.cols() == radii.size() && "Every center needs a radius.");
+        }
+        /**
+         * @brief The spheres of another set in the given order.
+         */
+        SphereSet(const SphereSet& spheres, const std::vector<size_t>& order):
+            coordinates_(order.size(), spheres.dimension()),
+            radii2_(order.size())
+        {
+            for (size_t i = 0; i < order.size(); ++i) {
+                coordinates_.row(i) = spheres.coordinates_.row(order[i]);
+                radii2_[i] = spheres.radii2_[order[i]];
+            }
+        }
+        virtual ~SphereSet() { }
+
+        /**
+         * @brief Weighted points given by their lifts (x, |x|^2 - w), one per
+         * column, as spheres with center x and squared radius w.
+         */
+        static SphereSet fromLifted(const Eigen::MatrixXd& lifted)
+        {
+            SphereSet spheres;
+            spheres.coordinates_ = lifted.topRows(lifted.rows() - 1).transpose();
+            spheres.radii2_ = spheres.coordinates_.rowwise().squaredNorm() -
+                lifted.row(lifted.rows() - 1).transpose();
+
+            return spheres;
+        }
+
+        size_t size() const
+        {
+            return radii2_.size();
+        }
+        size_t dimension() const
+        {
+            return coordinates_.cols();
+        }
+
+        Eigen::MatrixXd::ConstRowXpr center(size_t index) const
+        {
+            return coordinates_.row(index);
+        }
+        double radius2(size_t index) const
+        {
+            return radii2_[index];
+        }
+        /**
+         * @brief The coordinates as a matrix with one row per sphere.
+         */
+        const Eigen::MatrixXd& coordinates() const
+        {
+            return coordinates_;
+        }
+        const Eigen::VectorXd& radii2() const
+        {
+            return radii2_;
+        }
+
+        template <typename Point>
+        double power(size_t index, const Eigen::MatrixBase<Point>& point) const
+        {
+            return (center(index).transpose() - point).squaredNorm() - radii2_[index];
+        }
+
+        /**
+         * @brief The powers of point with respect to the spheres begin, ...,
+         * begin + length - 1.
+         * The squared distances are summed up one coordinate at a time for
+         * all of the spheres.
+         *
+         * @param powers Resized to length, which does not allocate for
+         * fixed-capacity vectors of sufficient size.
+         */
+        template <typename Point, typename Powers>
+        void powers(
+                size_t begin,
+                size_t length,
+                const Eigen::MatrixBase<Point>& point,
+                Eigen::PlainObjectBase<Powers>& powers) const
+        {
+            powers.resize(length);
+            powers = (coordinates_.col(0).segment(begin, length).array() - point[0]).square().matrix();
+            for (size_t i = 1; i < dimension(); ++i) {
+                powers.array() += (coordinates_.col(i).segment(begin, length).array() - point[i]).square();
+            }
+            powers -= radii2_.segment(begin, length);
+        }
+
+    private:
+        // One row per sphere, i.e. every coordinate is stored contiguously.
+        Eigen::MatrixXd coordinates_;
+        Eigen::VectorXd radii2_;
+};
+
+#endif
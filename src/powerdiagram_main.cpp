@@ -1,14 +1,22 @@
+#include "powerdiagram/ConvexHullParallel.hpp"
+#include "powerdiagram/ConvexHullQuickhull.hpp"
+#include "powerdiagram/FromBinary.hpp"
 #include "powerdiagram/FromCSV.hpp"
+#include "powerdiagram/FrozenIncidenceLattice.hpp"
 #include "powerdiagram/IncidenceLattice.hpp"
 #include "powerdiagram/PowerDiagramDual.hpp"
+#include "powerdiagram/PowerDiagramDynamic.hpp"
 #include "powerdiagram/PowerDiagramNaive.hpp"
+#include "powerdiagram/PowerLocator.hpp"
+#include "powerdiagram/SphereSet.hpp"
 
 #include <Eigen/Dense>
 #include <gflags/gflags.h>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #ifdef HAVE_QHULL
@@ -17,31 +25,71 @@
 
 #ifdef HAVE_QHULL
 DEFINE_bool(dual, true, "Run the Dual Algorithm");
-DEFINE_bool(draw, false, "Output Information needed to draw the Diagram (implies -dual and -nonaive)");
 DEFINE_bool(naive, false, "Run the Naive Algorithm");
+DEFINE_string(hull, "qhull", "Convex hull algorithm used by the Dual Algorithm (qhull or quickhull)");
 #else
-#define FLAGS_draw false
+DEFINE_bool(dual, false, "Run the Dual Algorithm");
 DEFINE_bool(naive, true, "Run the Naive Algorithm");
+DEFINE_string(hull, "quickhull", "Convex hull algorithm used by the Dual Algorithm (quickhull)");
 #endif
+DEFINE_bool(parallelhull, false, "Compute the convex hull of the Dual Algorithm in slabs on all threads (needs -hull=quickhull)");
+DEFINE_bool(draw, false, "Output Information needed to draw the Diagram (implies -dual and -nonaive)");
+DEFINE_uint64(naiveneighbors, 0, "Only form naive groups among the given number of power-nearest neighbors of each sphere (0 = all groups)");
+DEFINE_uint64(naivefrom, 0, "Only check the naive groups from this index on, e.g. to resume a run");
+DEFINE_uint64(naiveto, 0, "Only check the naive groups before this index (0 = all groups)");
+DEFINE_bool(dynamic, false, "Run the Dynamic Algorithm, which inserts the spheres one by one");
+DEFINE_string(locate, "", "CSV file of points to assign to the power cells (replaces the diagram output)");
+DEFINE_bool(parallelinput, false, "Parse the CSV input files on all threads");
 DEFINE_bool(verbose, false, "Verbose output");
 
 DECLARE_bool(help);
 DECLARE_string(helpmatch);
 
+/**
+ * @brief Create the convex hull algorithm chosen by --hull.
+ */
+static std::unique_ptr<ConvexHullAlgorithm> hullBackend()
+{
 #ifdef HAVE_QHULL
+    if (FLAGS_hull == "qhull") {
+        return std::unique_ptr<ConvexHullAlgorithm>(new ConvexHullQhull());
+    }
+#endif
+    if (FLAGS_hull == "quickhull") {
+        return std::unique_ptr<ConvexHullAlgorithm>(new ConvexHullQuickhull());
+    }
+
+    throw std::runtime_error("Unknown convex hull algorithm: " + FLAGS_hull);
+}
+
+/**
+ * @brief Create the convex hull algorithm for the Dual algorithm, which runs
+ * copies of the backend in parallel if --parallelhull is set.
+ */
+static std::unique_ptr<ConvexHullAlgorithm> hullAlgorithm()
+{
+    if (FLAGS_parallelhull) {
+        // Fail early for unknown backends.
+        hullBackend();
+        return std::unique_ptr<ConvexHullAlgorithm>(new ConvexHullParallel(hullBackend));
+    }
+
+    return hullBackend();
+}
+
 /**
  * @brief Outputs some general information about a power diagram using the Dual algorithm.
  *
- * @param spheres D-dimensional spheres in the format defined in PowerDiagram.hpp
+ * @param centers D-dimensional centers, one per column
+ * @param radii The radii of the spheres
  */
-template<typename Spheres>
-static void dual(const Spheres& spheres)
+static void dual(const PowerDiagram::Centers_t& centers, const PowerDiagram::Radii_t& radii)
 {
     std::cout << "Dual algorithm:" << std::endl;
 
-    ConvexHullQhull conv;
-    PowerDiagramDual dual(conv);
-    auto diagram = dual.fromSpheres(spheres);
+    auto conv = hullAlgorithm();
+    PowerDiagramDual dual(*conv);
+    const FrozenIncidenceLattice diagram(dual.fromSpheres(centers, radii));
 
     std::cout << "Number of minimal nodes: " << diagram.minimals().size() << std::endl;
     for (auto& minimal : diagram.minimals()) {
@@ -65,18 +113,17 @@ static void dual(const Spheres& spheres)
  * @brief Outputs the power diagram in an easily parseable format using the Dual algorithm.
  * See the util folder for a parser written in python.
  *
- * @param spheres D-dimensional spheres in the format defined in PowerDiagram.hpp
+ * @param centers D-dimensional centers, one per column
+ * @param radii The radii of the spheres
  */
-template<typename Spheres>
-static void draw(const Spheres& spheres)
+static void draw(const PowerDiagram::Centers_t& centers, const PowerDiagram::Radii_t& radii)
 {
-    ConvexHullQhull conv;
-    PowerDiagramDual dual(conv);
-    auto diagram = dual.fromSpheres(spheres);
-    using Key_t = typename decltype(diagram)::Key_t;
+    auto conv = hullAlgorithm();
+    PowerDiagramDual dual(*conv);
+    const FrozenIncidenceLattice diagram(dual.fromSpheres(centers, radii));
 
     // Give every sphere a number and output it.
-    std::unordered_map<Key_t, size_t> sphereMap;
+    std::vector<size_t> sphereMap(diagram.size());
     {
         size_t i = 1;
         for (auto& sphere : diagram.minimals()) {
@@ -91,7 +138,7 @@ static void draw(const Spheres& spheres)
     std::cout << std::endl;
 
     // Give every point (0-face) a number and output it
-    std::unordered_map<Key_t, size_t> pointMap;
+    std::vector<size_t> pointMap(diagram.size());
     {
         size_t i = 1;
         for (auto& point : diagram.maximals()) {
@@ -106,14 +153,14 @@ static void draw(const Spheres& spheres)
 
     // Output inner edges (1-face) as combination of points
     // And extremal edges (1-face) as a point and a direction
-    const auto dimension = std::get<0>(spheres[0]).size();
+    const auto dimension = centers.rows();
     if (dimension > 1) {
-        std::unordered_set<Key_t> visitedEdges;
+        std::vector<bool> visitedEdges(diagram.size(), false);
 
         for (auto& point : diagram.maximals()) {
             for (auto& edge : diagram.predecessors(point)) {
-                if (visitedEdges.find(edge) == visitedEdges.end()) {
-                    visitedEdges.insert(edge);
+                if (!visitedEdges[edge]) {
+                    visitedEdges[edge] = true;
 
                     const auto points = diagram.successors(edge);
                     if (points.size() == 1 ) {
@@ -143,20 +190,22 @@ static void draw(const Spheres& spheres)
         }
     }
 }
-#endif
 
 /**
  * @brief Outputs some general information about a power diagram using the naive algorithm.
  *
- * @param spheres D-dimensional spheres in the format defined in PowerDiagram.hpp
+ * @param centers D-dimensional centers, one per column
+ * @param radii The radii of the spheres
  */
-template<typename Spheres>
-static void naive(const Spheres& spheres)
+static void naive(const PowerDiagram::Centers_t& centers, const PowerDiagram::Radii_t& radii)
 {
     std::cout << "Naive algorithm:" << std::endl;
 
-    PowerDiagramNaive naive;
-    auto diagram = naive.fromSpheres(spheres);
+    PowerDiagramNaive naive(
+            FLAGS_naiveneighbors,
+            FLAGS_naivefrom,
+            FLAGS_naiveto == 0 ? std::numeric_limits<size_t>::max() : FLAGS_naiveto);
+    const FrozenIncidenceLattice diagram(naive.fromSpheres(centers, radii));
 
     std::cout << "Number of minimal nodes: " << diagram.minimals().size() << std::endl;
     for (auto& minimal : diagram.minimals()) {
@@ -169,13 +218,134 @@ static void naive(const Spheres& spheres)
     }
 }
 
+/**
+ * @brief Outputs some general information about a power diagram using the dynamic algorithm.
+ *
+ * @param centers D-dimensional centers, one per column
+ * @param radii The radii of the spheres
+ */
+static void dynamic(const PowerDiagram::Centers_t& centers, const PowerDiagram::Radii_t& radii)
+{
+    std::cout << "Dynamic algorithm:" << std::endl;
+
+    PowerDiagramDynamic dynamic;
+    const FrozenIncidenceLattice diagram(dynamic.fromSpheres(centers, radii));
+
+    std::cout << "Number of minimal nodes: " << diagram.minimals().size() << std::endl;
+    for (auto& minimal : diagram.minimals()) {
+        std::cout << "Minimal: " << diagram.value(minimal).transpose() << std::endl;
+    }
+
+    std::cout << "Number of maximal nodes: " << diagram.maximals().size() << std::endl;
+    for (auto& maximal : diagram.maximals()) {
+        std::cout << "Maximal: " << diagram.value(maximal).transpose() << std::endl;
+    }
+}
+
+/**
+ * @brief Outputs, for every point in a CSV file, the index of the sphere
+ * whose power cell contains it.
+ *
+ * @param centers D-dimensional centers, one per column
+ * @param radii The radii of the spheres
+ * @param file CSV file with one D-dimensional point per line.
+ */
+static void locate(
+        const PowerDiagram::Centers_t& centers,
+        const PowerDiagram::Radii_t& radii,
+        const char* file)
+{
+    Eigen::MatrixXd points;
+    FromCSV::points(file, points);
+
+    const auto dimension = centers.rows();
+    if (points.cols() > 0 && points.rows() != dimension) {
+        throw std::runtime_error(std::string(file) + ": Expected points with " +
+                std::to_string(dimension) + " coordinates");
+    }
+
+    const PowerLocator locator{SphereSet(centers, radii)};
+    for (auto& owner : locator.locateAll(points)) {
+        std::cout << owner << "\n";
+    }
+    std::cout << std::flush;
+}
+
+/**
+ * @brief Runs the algorithms chosen by the flags on the spheres.
+ *
+ * @param centers D-dimensional centers, one per column
+ * @param radii The radii of the spheres
+ *
+ * @return The exit code of the program.
+ */
+static int run(const PowerDiagram::Centers_t& centers, const PowerDiagram::Radii_t& radii)
+{
+    if (radii.size() < 1) {
+        std::cerr << "Error: Empty input. Maybe the Filenames are wrong?"<< std::endl;
+        return 1;
+    }
+
+    if (FLAGS_verbose) {
+      std::cerr << "Spheres:" << std::endl;
+      for (Eigen::Index i = 0; i < radii.size(); ++i) {
+        std::cerr
+          << "Center: "
+          << centers.col(i).transpose()
+          << " - Radius: "
+          << radii[i]
+          << std::endl;
+      }
+      std::cerr << std::endl << std::endl;
+    }
+
+    if (!FLAGS_locate.empty()) {
+        try {
+            locate(centers, radii, FLAGS_locate.c_str());
+        } catch (const std::runtime_error& error) {
+            std::cerr << "Error: " << error.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    try {
+        if (FLAGS_draw) {
+            draw(centers, radii);
+        } else if (FLAGS_dual) {
+            dual(centers, radii);
+        }
+    } catch (const std::runtime_error& error) {
+        std::cerr << "Error: " << error.what() << std::endl;
+        return 1;
+    }
+
+    if (FLAGS_naive && !FLAGS_draw) {
+        try {
+            naive(centers, radii);
+        } catch (const std::runtime_error& error) {
+            std::cerr << "Error: " << error.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (FLAGS_dynamic && !FLAGS_draw) {
+        dynamic(centers, radii);
+    }
+
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     std::string usage;
     usage += "This program calculates powerdiagrams from a set of spheres in n dimensions.\n";
     usage += "Sample usage:\n\t";
     usage += argv[0];
-    usage += " [Options] <centers> <radii>\n";
+    usage += " [Options] <centers> <radii>\n\t";
+    usage += argv[0];
+    usage += " [Options] <spheres>.spheres\n";
+    usage += "Binary sphere files can be created from CSV files using csv2spheres.\n";
     usage += "For a complete help, use options --help or --helpfull.\n";
     gflags::SetUsageMessage(usage);
     gflags::ParseCommandLineNonHelpFlags(&argc, &argv, true);
@@ -185,42 +355,41 @@ int main(int argc, char *argv[])
     }
     gflags::HandleCommandLineHelpFlags();
 
-    if (argc < 3) {
+    if (FLAGS_naiveneighbors != 0 && (FLAGS_naivefrom != 0 || FLAGS_naiveto != 0)) {
+        std::cerr << "Error: -naivefrom and -naiveto only apply without -naiveneighbors" << std::endl;
+        return 1;
+    }
+    // The slabs are merged the way quickhull merges nearly coplanar facets,
+    // so the result is only the serial hull's for that backend.
+    if (FLAGS_parallelhull && FLAGS_hull != "quickhull") {
+        std::cerr << "Error: -parallelhull only supports -hull=quickhull" << std::endl;
+        return 1;
+    }
+
+    const bool binaryInput = argc >= 2 && FromBinary::isBinary(argv[1]);
+    if (argc < 3 && !binaryInput) {
         std::cout << gflags::ProgramUsage();
         return 2;
     } else {
-        const auto& spheres = FromCSV::spheres(argv[1], argv[2]);
-
-        if (spheres.size() < 1) {
-            std::cerr << "Error: Empty input. Maybe the Filenames are wrong?"<< std::endl;
+        // Binary files are used in place, so the mapping has to outlive
+        // the algorithms.
+        std::unique_ptr<FromBinary::Mapped> mapped;
+        Eigen::MatrixXd centers;
+        Eigen::VectorXd radii;
+        try {
+            if (binaryInput) {
+                mapped.reset(new FromBinary::Mapped(argv[1]));
+            } else {
+                FromCSV::read(argv[1], argv[2], centers, radii, FLAGS_parallelinput);
+            }
+        } catch (const std::runtime_error& error) {
+            std::cerr << "Error: " << error.what() << std::endl;
             return 1;
         }
 
-        if (FLAGS_verbose) {
-          std::cerr << "Spheres:" << std::endl;
-          for (auto& item : spheres) {
-            std::cerr
-              << "Center: "
-              << std::get<0>(item).transpose()
-              << " - Radius: "
-              << std::get<1>(item)
-              << std::endl;
-          }
-          std::cerr << std::endl << std::endl;
-        }
-
-#ifdef HAVE_QHULL
-        if (FLAGS_draw) {
-            draw(spheres);
-        } else if (FLAGS_dual) {
-            dual(spheres);
+        if (mapped) {
+            return run(mapped->centers(), mapped->radii());
         }
-#endif
-
-        if (FLAGS_naive && !FLAGS_draw) {
-            naive(spheres);
-        }
-
-        return 0;
+        return run(centers, radii);
     }
 }
@@ -0,0 +1,122 @@
+#!/usr/bin/env python
+"""
+Checks that --parallelhull merges the hulls of its slabs on random input
+instead of falling back to the serial hull, and that the diagram it yields
+is the one of the serial hull. This is checked for quickhull and for the
+default backend, which may also refuse --parallelhull instead.
+
+usage: checkParallelHull.py path/to/powerdiagram [threads]
+"""
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+# (name, dimension, count, equal radii)
+CASES = [
+    ("2d", 2, 40000, False),
+    ("3d", 3, 30000, False),
+    ("3d equal radii", 3, 30000, True),
+]
+
+def writeInput(directory, dimension, count, equal, seed):
+    generator = random.Random(seed)
+    sitesFile = os.path.join(directory, "sites.csv")
+    radiiFile = os.path.join(directory, "radii.csv")
+    with open(sitesFile, "w") as sites, open(radiiFile, "w") as radii:
+        for i in range(count):
+            center = [generator.uniform(0, 100) for _ in range(dimension)]
+            radius = 1 if equal else generator.uniform(0.5, 1)
+            sites.write(",".join("{:.9f}".format(x) for x in center) + "\n")
+            radii.write("{:.9f}\n".format(radius))
+
+    return sitesFile, radiiFile
+
+def run(binary, arguments):
+    process = subprocess.Popen(
+        [binary] + arguments,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        universal_newlines=True)
+    out, err = process.communicate()
+    if process.returncode != 0:
+        raise RuntimeError("{} failed:\n{}".format(binary, err))
+
+    return out, err
+
+def rounded(line):
+    return " ".join("{:.6g}".format(float(x)) for x in line.split())
+
+# The vertices and the faces (power vertex and edges) of the diagram,
+# independent of the order in which they are printed.
+def canonical(output):
+    minimals = set()
+    maximals = []
+    current = None
+    for line in output.splitlines():
+        if line.startswith("Minimal:"):
+            minimals.add(rounded(line[len("Minimal:"):]))
+        elif line.startswith("Maximal:"):
+            current = (rounded(line[len("Maximal:"):]), [])
+            maximals.append(current)
+        elif line.startswith("Id:"):
+            current[1].append([])
+        elif line.startswith("  - "):
+            current[1][-1].append(rounded(line[4:]))
+
+    faces = set()
+    for value, predecessors in maximals:
+        faces.add((value, tuple(sorted(tuple(sorted(p)) for p in predecessors))))
+
+    return minimals, faces
+
+def check(binary, threads, name, dimension, count, equal, seed, hull):
+    directory = tempfile.mkdtemp()
+    sitesFile, radiiFile = writeInput(directory, dimension, count, equal, seed)
+
+    common = ["--dual", "--nonaive"] + hull + [sitesFile, radiiFile]
+    serial, _ = run(binary, common)
+    try:
+        parallel, log = run(binary, ["--parallelhull", "--threads={}".format(threads), "--verbose"] + common)
+    except RuntimeError as error:
+        if not hull and "-parallelhull only supports" in str(error):
+            print("{}: the default backend refuses --parallelhull".format(name))
+            return True
+        raise
+
+    ok = True
+    if "Parallel hull failed" in log or "Merged the hulls" not in log:
+        print("{}: the parallel hull fell back to the serial one".format(name))
+        ok = False
+
+    serialVertices, serialFaces = canonical(serial)
+    parallelVertices, parallelFaces = canonical(parallel)
+    if serialVertices != parallelVertices:
+        print("{}: the spheres differ from the serial hull".format(name))
+        ok = False
+    elif serialFaces != parallelFaces:
+        print("{}: {} of {} faces differ from the serial hull".format(
+            name, len(serialFaces ^ parallelFaces), len(serialFaces)))
+        ok = False
+
+    if ok:
+        print("{}: merged".format(name))
+
+    return ok
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__.strip())
+        sys.exit(2)
+
+    binary = sys.argv[1]
+    threads = int(sys.argv[2]) if len(sys.argv) > 2 else 8
+
+    ok = True
+    for hull in (["--hull=quickhull"], []):
+        for seed, (name, dimension, count, equal) in enumerate(CASES):
+            name = "{} ({})".format(name, hull[0] if hull else "default backend")
+            ok = check(binary, threads, name, dimension, count, equal, seed, hull) and ok
+
+    sys.exit(0 if ok else 1)